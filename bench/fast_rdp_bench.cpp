@@ -0,0 +1,504 @@
+// Benchmarks of the rdp engines, on nanobench:
+//
+//      fast_rdp_bench [--max-n N] [--filter SUBSTR] [--json PATH]
+//                     [--baseline PATH [--threshold 0.05] [--alpha 0.01]]
+//
+// every engine runs on 2d & 3d random walks of 10 .. max-n (default 10^6,
+// up to 10^8) points at several epsilons, and on the degenerate shape of
+// test_degenerate_case. Reports ns/point (median over epochs), points/s and
+// the p99 of ns/point over epochs.
+//
+// a second table has the hardware counters (linux perf_event, needs
+// kernel.perf_event_paranoid <= 2 or CAP_PERFMON, else n/a) per point:
+// instructions, IPC, branch misses (clamps of LineSegment::distance2) and
+// last-level cache misses, from L1-resident (N = 10^3, 24 KB) to
+// DRAM-resident (N >= 10^6) inputs.
+//
+// --json writes the results (with all epochs) in nanobench's json format,
+// --baseline compares the run to such a file: a case regressed if its median
+// ns/point is more than threshold slower and the epochs are significantly
+// slower (one-sided Mann-Whitney U test, p < alpha). Exits with 2 if any
+// case regressed, with 1 if the baseline can't be read.
+
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include "network.hpp"
+#include "sleeve.hpp"
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace fast_rdp;
+
+namespace
+{
+struct Engine
+{
+    const char *name;
+    std::function<int(const RowVectors &, double)> run; // -> #kept
+};
+
+// new engines (simd, ...) go here
+std::vector<Engine> engines()
+{
+    return {
+        {"recursive",
+         [](const RowVectors &coords, double epsilon) {
+             return douglas_simplify_mask(coords, epsilon, true,
+                                          DistanceMetric::Segment)
+                 .sum();
+         }},
+        {"iterative",
+         [](const RowVectors &coords, double epsilon) {
+             return douglas_simplify_mask(coords, epsilon, false,
+                                          DistanceMetric::Segment)
+                 .sum();
+         }},
+        // bounded-error, not the exact rdp mask
+        {"approx",
+         [](const RowVectors &coords, double epsilon) {
+             return douglas_simplify_approx_mask(coords, epsilon,
+                                                 SegmentMetric{})
+                 .sum();
+         }},
+        // online, one pass (same bound, greedy: not the rdp mask)
+        {"sleeve",
+         [](const RowVectors &coords, double epsilon) {
+             return sleeve_simplify_mask(coords, epsilon).sum();
+         }},
+        // the line cut into lines of 1024 points, simplified in parallel
+        {"batch",
+         [](const RowVectors &coords, double epsilon) {
+             std::vector<RowVectors> lines;
+             for (int i = 0, N = coords.rows(); i < N; i += 1023) {
+                 lines.push_back(coords.middleRows(i, std::min(1024, N - i)));
+             }
+             int kept = 0;
+             for (auto &mask : douglas_simplify_batch_masks(
+                      lines, epsilon, true, DistanceMetric::Segment, false,
+                      false)) {
+                 kept += mask.sum();
+             }
+             return kept;
+         }},
+    };
+}
+
+RowVectors random_walk(int N, int dims, uint32_t seed = 0)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+    RowVectors coords = RowVectors::Zero(N, 3);
+    for (int i = 1; i < N; ++i) {
+        for (int d = 0; d < dims; ++d) {
+            coords(i, d) = coords(i - 1, d) + step(rng);
+        }
+    }
+    return coords;
+}
+
+// https://github.com/mapbox/geojson-vt/issues/104
+RowVectors degenerate(int repeats = 14000)
+{
+    RowVectors coords = RowVectors::Zero(4 * repeats, 3);
+    for (int i = 0; i < repeats; ++i) {
+        coords.row(4 * i + 1) << 1.0, 0.0, 0.0;
+        coords.row(4 * i + 2) << 1.0, 1.0, 0.0;
+        coords.row(4 * i + 3) << 0.0, 1.0, 0.0;
+    }
+    return coords;
+}
+
+// last-level cache misses of this thread (nanobench doesn't read them)
+class LlcMisses
+{
+  public:
+    LlcMisses()
+    {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~LlcMisses()
+    {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+    LlcMisses(const LlcMisses &) = delete;
+    LlcMisses &operator=(const LlcMisses &) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+    // misses while running fn, nan if not available
+    template <typename Fn> double count(Fn &&fn)
+    {
+        if (!ok()) {
+            fn();
+            return NAN;
+        }
+        long long value = 0;
+#if defined(__linux__)
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        fn();
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &value, sizeof(value)) != sizeof(value)) {
+            return NAN;
+        }
+#endif
+        return value;
+    }
+
+  private:
+    int fd_ = -1;
+};
+
+struct Row
+{
+    std::string engine, shape;
+    int dims;
+    long N;
+    double epsilon;
+    double ns_per_point, points_per_second, p99, error;
+    long kept;
+    // per point, nan if not available
+    double instructions, ipc, branch_misses, llc_misses;
+};
+
+using Measure = ankerl::nanobench::Result::Measure;
+
+// ns/point of every epoch, sorted
+std::vector<double> epochs(const ankerl::nanobench::Result &result)
+{
+    std::vector<double> values;
+    for (size_t i = 0; i < result.size(); ++i) {
+        values.push_back(result.get(i, Measure::elapsed) * 1e9 /
+                         result.config().mBatch);
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+// nearest-rank percentile of sorted values
+double percentile(const std::vector<double> &values, double p)
+{
+    size_t rank = std::ceil(p * values.size());
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+double median(const std::vector<double> &values)
+{
+    const size_t n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+// one-sided Mann-Whitney U test (normal approximation, ties count 1/2):
+// p-value of "a is stochastically greater than b"
+double mann_whitney_greater(const std::vector<double> &a,
+                            const std::vector<double> &b)
+{
+    double U = 0.0;
+    for (double x : a) {
+        for (double y : b) {
+            U += x > y ? 1.0 : (x == y ? 0.5 : 0.0);
+        }
+    }
+    const double n1 = a.size(), n2 = b.size();
+    const double sigma = std::sqrt(n1 * n2 * (n1 + n2 + 1) / 12.0);
+    const double z = (U - n1 * n2 / 2.0 - 0.5) / sigma; // continuity
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// name -> sorted ns/point of the epochs, from nanobench's json output
+std::map<std::string, std::vector<double>>
+read_baseline(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("failed to open " + path);
+    }
+    rapidjson::IStreamWrapper is(file);
+    rapidjson::Document doc;
+    // counters nanobench couldn't read are written as nan
+    doc.ParseStream<rapidjson::kParseNanAndInfFlag>(is);
+    auto invalid = [&](const std::string &what) {
+        return std::runtime_error("invalid baseline: " + path + ", " + what);
+    };
+    if (doc.HasParseError() || !doc.IsObject()) {
+        throw invalid("not a json object");
+    }
+    // member of an object, checked before use (rapidjson asserts otherwise)
+    using Value = rapidjson::Value;
+    auto member = [&](const Value &object, const char *name,
+                      bool (Value::*is)() const,
+                      const char *type) -> const Value & {
+        const std::string expected =
+            std::string("expected ") + type + " \"" + name + "\"";
+        if (!object.IsObject()) {
+            throw invalid(expected + " in an object");
+        }
+        auto it = object.FindMember(name);
+        if (it == object.MemberEnd() || !(it->value.*is)()) {
+            throw invalid(expected);
+        }
+        return it->value;
+    };
+    std::map<std::string, std::vector<double>> baseline;
+    const auto &results = member(doc, "results", &Value::IsArray, "array");
+    for (const auto &result : results.GetArray()) {
+        const double batch =
+            member(result, "batch", &Value::IsNumber, "number").GetDouble();
+        if (!(batch > 0)) {
+            throw invalid("batch should be positive");
+        }
+        const auto &name = member(result, "name", &Value::IsString, "string");
+        const auto &measurements =
+            member(result, "measurements", &Value::IsArray, "array");
+        auto &values = baseline[name.GetString()];
+        for (const auto &m : measurements.GetArray()) {
+            const double elapsed =
+                member(m, "elapsed", &Value::IsNumber, "number").GetDouble();
+            values.push_back(elapsed * 1e9 / batch);
+        }
+        std::sort(values.begin(), values.end());
+    }
+    return baseline;
+}
+
+// prints a comparison table, returns the number of regressions
+int compare(const std::vector<ankerl::nanobench::Result> &results,
+            const std::map<std::string, std::vector<double>> &baseline,
+            double threshold, double alpha)
+{
+    int regressions = 0;
+    std::printf("\n| case | baseline ns/point | ns/point | change | p | |\n");
+    std::printf("|---|--:|--:|--:|--:|---|\n");
+    for (const auto &result : results) {
+        const auto &name = result.config().mBenchmarkName;
+        auto it = baseline.find(name);
+        if (it == baseline.end() || it->second.empty()) {
+            std::printf("| %s | | | | | new |\n", name.c_str());
+            continue;
+        }
+        const auto current = epochs(result);
+        const double before = median(it->second), after = median(current);
+        const double change = after / before - 1.0;
+        const char *verdict = "";
+        double p = 1.0;
+        if (change > threshold) {
+            p = mann_whitney_greater(current, it->second);
+            if (p < alpha) {
+                verdict = "REGRESSION";
+                ++regressions;
+            }
+        } else if (change < -threshold) {
+            p = mann_whitney_greater(it->second, current);
+            verdict = p < alpha ? "faster" : "";
+        }
+        std::printf("| %s | %.2f | %.2f | %+.1f%% | %.3g | %s |\n",
+                    name.c_str(), before, after, change * 100, p, verdict);
+    }
+    std::printf("\n%d regression(s) (threshold %.1f%%, alpha %g)\n",
+                regressions, threshold * 100, alpha);
+    return regressions;
+}
+
+// median of a counter per point, nan if not available
+double per_point(const ankerl::nanobench::Result &result, Measure m, double N)
+{
+    return result.has(m) ? result.median(m) / N : NAN;
+}
+
+Row bench(const std::string &name, const Engine &engine,
+          const std::string &shape, int dims, const RowVectors &coords,
+          double epsilon, std::vector<ankerl::nanobench::Result> &results,
+          LlcMisses &llc)
+{
+    const double N = coords.rows();
+    long kept = 0;
+    // 2d input goes through to_Nx3, as in rdp()
+    const RowVectorsNx2 xys = coords.leftCols(2);
+    auto run = [&] {
+        kept = dims == 2 ? engine.run(to_Nx3(xys), epsilon)
+                         : engine.run(coords, epsilon);
+        ankerl::nanobench::doNotOptimizeAway(kept);
+    };
+    ankerl::nanobench::Bench b;
+    // enough epochs for a p99 on small inputs, few on huge ones
+    b.output(nullptr).unit("point").batch(N).epochs(N <= 1e5 ? 101 : 5);
+    b.performanceCounters(true).run(name, run);
+    const auto &result = b.results().front();
+    results.push_back(result);
+    // llc misses over >= 10^6 points, outside of nanobench's loop
+    const int repeats = std::max(1.0, 1e6 / N);
+    const double llc_misses = llc.count([&] {
+        for (int i = 0; i < repeats; ++i) {
+            run();
+        }
+    });
+    const double seconds = result.median(Measure::elapsed) / N;
+    const double instructions = per_point(result, Measure::instructions, N);
+    return {engine.name,
+            shape,
+            dims,
+            long(N),
+            epsilon,
+            seconds * 1e9,
+            1.0 / seconds,
+            percentile(epochs(result), 0.99),
+            result.medianAbsolutePercentError(Measure::elapsed) * 100,
+            kept,
+            instructions,
+            instructions / per_point(result, Measure::cpucycles, N),
+            per_point(result, Measure::branchmisses, N),
+            llc_misses / (repeats * N)};
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long max_n = 1000000;
+    std::string filter, json_path, baseline_path;
+    double threshold = 0.05, alpha = 0.01;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = [&](const char *flag) {
+            return !std::strcmp(argv[i], flag) && i + 1 < argc;
+        };
+        if (arg("--max-n")) {
+            max_n = std::atol(argv[++i]);
+        } else if (arg("--filter")) {
+            filter = argv[++i];
+        } else if (arg("--json")) {
+            json_path = argv[++i];
+        } else if (arg("--baseline")) {
+            baseline_path = argv[++i];
+        } else if (arg("--threshold")) {
+            threshold = std::atof(argv[++i]);
+        } else if (arg("--alpha")) {
+            alpha = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--max-n N] [--filter SUBSTR] [--json "
+                         "PATH] [--baseline PATH [--threshold 0.05] [--alpha "
+                         "0.01]]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+    std::map<std::string, std::vector<double>> baseline;
+    if (!baseline_path.empty()) {
+        // fail early, not after the run
+        try {
+            baseline = read_baseline(baseline_path);
+        } catch (const std::runtime_error &e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    }
+
+    std::vector<Row> rows;
+    std::vector<ankerl::nanobench::Result> results;
+    LlcMisses llc;
+    if (!llc.ok()) {
+        std::fprintf(stderr, "no perf_event counters (see "
+                             "/proc/sys/kernel/perf_event_paranoid)\n");
+    }
+    auto run = [&](const std::string &shape, int dims,
+                   const RowVectors &coords, double epsilon) {
+        for (const auto &engine : engines()) {
+            char name[256];
+            std::snprintf(name, sizeof(name), "%s/%s/%dd/%ld/%g", engine.name,
+                          shape.c_str(), dims, long(coords.rows()), epsilon);
+            if (!filter.empty() &&
+                std::string(name).find(filter) == std::string::npos) {
+                continue;
+            }
+            rows.push_back(bench(name, engine, shape, dims, coords, epsilon,
+                                 results, llc));
+            const auto &r = rows.back();
+            std::fprintf(stderr, "%-48s %10.2f ns/point\n", name,
+                         r.ns_per_point);
+        }
+    };
+    for (int dims : {2, 3}) {
+        for (long N = 10; N <= max_n; N *= 10) {
+            const RowVectors coords = random_walk(N, dims);
+            for (double epsilon : {0.1, 1.0, 10.0}) {
+                run("random_walk", dims, coords, epsilon);
+            }
+        }
+        run("degenerate", dims, degenerate(), 2e-15);
+    }
+
+    std::printf("| engine | shape | dims | N | epsilon | ns/point | points/s "
+                "| p99 ns/point | err%% | kept |\n");
+    std::printf("|---|---|--:|--:|--:|--:|--:|--:|--:|--:|\n");
+    for (const auto &r : rows) {
+        std::printf("| %s | %s | %d | %ld | %g | %.2f | %.4g | %.2f | %.1f | "
+                    "%ld |\n",
+                    r.engine.c_str(), r.shape.c_str(), r.dims, r.N, r.epsilon,
+                    r.ns_per_point, r.points_per_second, r.p99, r.error,
+                    r.kept);
+    }
+
+    // nan -> n/a
+    auto counter = [](double value, const char *format) {
+        char s[32] = "n/a";
+        if (!std::isnan(value)) {
+            std::snprintf(s, sizeof(s), format, value);
+        }
+        return std::string(s);
+    };
+    std::printf("\n| engine | shape | dims | N | epsilon | ins/point | IPC | "
+                "branch misses/point | LLC misses/point |\n");
+    std::printf("|---|---|--:|--:|--:|--:|--:|--:|--:|\n");
+    for (const auto &r : rows) {
+        std::printf("| %s | %s | %d | %ld | %g | %s | %s | %s | %s |\n",
+                    r.engine.c_str(), r.shape.c_str(), r.dims, r.N, r.epsilon,
+                    counter(r.instructions, "%.1f").c_str(),
+                    counter(r.ipc, "%.2f").c_str(),
+                    counter(r.branch_misses, "%.3f").c_str(),
+                    counter(r.llc_misses, "%.4f").c_str());
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        ankerl::nanobench::render(ankerl::nanobench::templates::json(),
+                                  results, out);
+    }
+    if (!baseline_path.empty() &&
+        compare(results, baseline, threshold, alpha) > 0) {
+        return 2;
+    }
+    return 0;
+}
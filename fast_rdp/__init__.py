@@ -1,39 +1,206 @@
+import contextlib
 import sys
 
 import numpy as np
+from _fast_rdp import CancellationToken  # noqa
+from _fast_rdp import Cancelled  # noqa
+from _fast_rdp import DeadReckoning  # noqa
+from _fast_rdp import GeoJSONVT  # noqa
 from _fast_rdp import LineSegment  # noqa
+from _fast_rdp import MultiResolutionIndex  # noqa
+from _fast_rdp import RdpStats  # noqa
+from _fast_rdp import SleeveSimplifier  # noqa
+from _fast_rdp import SquishE  # noqa
 from _fast_rdp import __version__  # noqa
+from _fast_rdp import build_multires_index  # noqa
+from _fast_rdp import dead_reckoning  # noqa
+from _fast_rdp import dead_reckoning_mask  # noqa
+from _fast_rdp import decode_polylines  # noqa
+from _fast_rdp import encode_mvt  # noqa
+from _fast_rdp import encode_polyline  # noqa
+from _fast_rdp import encode_polylines  # noqa
+from _fast_rdp import has_zlib  # noqa
+from _fast_rdp import rdp_batch as _rdp_batch  # noqa
+from _fast_rdp import rdp_batch_mask  # noqa
 from _fast_rdp import rdp_mask  # noqa
+from _fast_rdp import rdp_network as _rdp_network  # noqa
+from _fast_rdp import rdp_network_mask  # noqa
 from _fast_rdp import rdp as _rdp  # noqa
+from _fast_rdp import read_flatgeobuf  # noqa
+from _fast_rdp import simplification_error  # noqa
+from _fast_rdp import simplify_flatgeobuf  # noqa
+from _fast_rdp import simplify_geojson  # noqa
+from _fast_rdp import sleeve  # noqa
+from _fast_rdp import sleeve_mask  # noqa
+from _fast_rdp import squish  # noqa
+from _fast_rdp import squish_mask  # noqa
+from _fast_rdp import start_trace  # noqa
+from _fast_rdp import stop_trace  # noqa
+from _fast_rdp import write_flatgeobuf  # noqa
 
+METRICS = ("segment", "line", "horizontal", "vertical", "sed")
 
-def __notify_dist_fn(dist):
+
+def __metric(dist):
+    """
+    dist can be a metric name (one of METRICS), or `rdp.pldist` of the python
+    rdp package (mapped to "line"). other dist functions are not supported.
+    """
     if dist is None:
-        return
+        return "segment"
+    if isinstance(dist, str):
+        return dist
+    if getattr(dist, "__name__", None) == "pldist":
+        return "line"
     print(
-        "we don't support dist function, the only built-in dist function is dist(point,line_segment) (NOT dist(point,line))",
+        "we don't support custom dist function, "
+        f"use one of built-in metrics by name: {METRICS}, "
+        "falling back to dist(point,line_segment)",
         file=sys.stderr,
     )
+    return "segment"
+
+
+@contextlib.contextmanager
+def trace(path):
+    """
+    records parallel tasks (begin/end, line id, N, engine, thread) while in the
+    block, then writes them to path as Chrome trace-event JSON (for Perfetto):
+
+        with fast_rdp.trace("trace.json"):
+            rdp_batch(lines, epsilon=1.0)
+    """
+    start_trace()
+    try:
+        yield
+    finally:
+        stop_trace(path)
 
 
 def rdp_rec(points, epsilon: float, dist=None):
-    __notify_dist_fn(dist)
     points = np.asarray(points, dtype=np.float64)
-    return _rdp(points, epsilon=epsilon, recursive=True)
+    return _rdp(points, epsilon=epsilon, recursive=True, metric=__metric(dist))
 
 
 def rdp_iter(points, epsilon: float, dist=None, return_mask=False):
-    __notify_dist_fn(dist)
+    metric = __metric(dist)
     points = np.asarray(points, dtype=np.float64)
     if return_mask:
-        return rdp_mask(points, epsilon=epsilon, recursive=False)
-    return _rdp(points, epsilon=epsilon, recursive=False)
+        return rdp_mask(points, epsilon=epsilon, recursive=False, metric=metric)
+    return _rdp(points, epsilon=epsilon, recursive=False, metric=metric)
 
 
-def rdp(points, epsilon: float = 0.0, dist=None, algo="iter", return_mask=False):
-    __notify_dist_fn(dist)
-    points = np.asarray(points, dtype=np.float64)
-    recursive = "iter" != algo
+def rdp(
+    points,
+    epsilon: float = 0.0,
+    dist=None,
+    algo="iter",
+    return_mask=False,
+    *,
+    epsilon_xy: float = None,
+    epsilon_z: float = None,
+    preserve_topology: bool = False,
+    return_stats: bool = False,
+    timeout: float = None,
+    cancel: CancellationToken = None,
+    on_timeout: str = "partial",
+):
+    """
+    algo: "iter", "rec", or "approx" (bounded-error: every dropped point is within
+    epsilon of the output, but not the exact rdp output, faster on long lines)
+    epsilon_xy/epsilon_z: separate horizontal/vertical tolerances (instead of
+    epsilon), a point is kept if it exceeds either of them
+    preserve_topology: output does not self-intersect (in xy-plane)
+    return_stats: return (result, RdpStats), counters of the simplification
+    timeout (seconds)/cancel: stop early, on_timeout="partial" returns the coarser
+    (valid) result found so far, "raise" raises Cancelled
+    int32/int16 Nx2 arrays: exact integer engine, output keeps the dtype (only
+    with the "segment" metric and no other option, |coords| < 2^30, else float64)
+    """
+    kwargs = dict(
+        epsilon=float(epsilon),
+        recursive="iter" != algo,
+        metric=__metric(dist),
+        epsilon_xy=epsilon_xy,
+        epsilon_z=epsilon_z,
+        preserve_topology=preserve_topology,
+        return_stats=return_stats,
+        timeout=timeout,
+        cancel=cancel,
+        on_timeout=on_timeout,
+        approximate="approx" == algo,
+    )
+    # only int32/int16 arrays may go to the integer engine, not lists (their
+    # dtype depends on the platform)
+    if not (isinstance(points, np.ndarray) and points.dtype in (np.int32, np.int16)):
+        points = np.asarray(points, dtype=np.float64)
+    if return_mask:
+        return rdp_mask(points, **kwargs)
+    return _rdp(points, **kwargs)
+
+
+def __batch(fn, fn_mask, lines, epsilon, dist, algo, return_mask, **kwargs):
+    kwargs = dict(
+        epsilon=epsilon,
+        recursive="iter" != algo,
+        metric=__metric(dist),
+        **kwargs,
+    )
+    lines = [np.asarray(line, dtype=np.float64) for line in lines]
     if return_mask:
-        return rdp_mask(points, epsilon=epsilon, recursive=recursive)
-    return _rdp(points, epsilon=epsilon, recursive=recursive)
+        return fn_mask(lines, **kwargs)
+    return fn(lines, **kwargs)
+
+
+def rdp_batch(
+    lines,
+    epsilon: float = 0.0,
+    dist=None,
+    algo="iter",
+    return_mask=False,
+    *,
+    preserve_topology: bool = False,
+    num_threads: int = 0,
+):
+    """
+    simplify lines in parallel
+    preserve_topology: simplified lines do not cross each other (or themselves)
+    """
+    return __batch(
+        _rdp_batch,
+        rdp_batch_mask,
+        lines,
+        epsilon,
+        dist,
+        algo,
+        return_mask,
+        preserve_topology=preserve_topology,
+        num_threads=num_threads,
+    )
+
+
+def rdp_network(
+    lines,
+    epsilon: float = 0.0,
+    dist=None,
+    algo="iter",
+    return_mask=False,
+    *,
+    preserve_topology: bool = False,
+    num_threads: int = 0,
+):
+    """
+    simplify lines of a network in parallel, vertices shared by several lines
+    (same coordinates) are kept so the network stays connected
+    """
+    return __batch(
+        _rdp_network,
+        rdp_network_mask,
+        lines,
+        epsilon,
+        dist,
+        algo,
+        return_mask,
+        preserve_topology=preserve_topology,
+        num_threads=num_threads,
+    )
@@ -0,0 +1,68 @@
+import argparse
+
+import contextlib
+
+from fast_rdp import METRICS, simplify_flatgeobuf, simplify_geojson, trace
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(prog="python3 -m fast_rdp")
+    parser.add_argument(
+        "--trace", metavar="PATH", help="write a Chrome trace-event JSON of the run"
+    )
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    p = subparsers.add_parser(
+        "simplify_geojson", help="simplify a GeoJSON FeatureCollection (streaming)"
+    )
+    p.add_argument("input_path")
+    p.add_argument("output_path")
+    p.add_argument("--epsilon", type=float, default=0.0)
+    p.add_argument("--metric", choices=METRICS, default="segment")
+    p.add_argument("--preserve-topology", action="store_true")
+    p.add_argument("--window", type=int, default=1024)
+    p.add_argument("--num-threads", type=int, default=0)
+
+    p = subparsers.add_parser(
+        "simplify_flatgeobuf", help="simplify a FlatGeobuf file (memory-mapped)"
+    )
+    p.add_argument("input_path")
+    p.add_argument("output_path")
+    p.add_argument("--epsilon", type=float, default=0.0)
+    p.add_argument("--metric", choices=METRICS, default="segment")
+    p.add_argument("--preserve-topology", action="store_true")
+    p.add_argument("--no-index", action="store_true")
+    p.add_argument("--num-threads", type=int, default=0)
+
+    args = parser.parse_args(argv)
+    with trace(args.trace) if args.trace else contextlib.nullcontext():
+        run(args)
+
+
+def run(args):
+    if args.command == "simplify_geojson":
+        num_features = simplify_geojson(
+            args.input_path,
+            args.output_path,
+            epsilon=args.epsilon,
+            metric=args.metric,
+            preserve_topology=args.preserve_topology,
+            window=args.window,
+            num_threads=args.num_threads,
+        )
+        print(f"wrote {num_features} features to {args.output_path}")
+    elif args.command == "simplify_flatgeobuf":
+        num_features = simplify_flatgeobuf(
+            args.input_path,
+            args.output_path,
+            epsilon=args.epsilon,
+            metric=args.metric,
+            preserve_topology=args.preserve_topology,
+            index=not args.no_index,
+            num_threads=args.num_threads,
+        )
+        print(f"wrote {num_features} features to {args.output_path}")
+
+
+if __name__ == "__main__":
+    main()
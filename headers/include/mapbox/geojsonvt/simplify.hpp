@@ -78,8 +78,13 @@ inline void simplify(std::vector<vt_point> &points, size_t first, size_t last,
     }
 }
 
+// MAPBOX_GEOJSONVT_SIMPLIFY: a replacement for simplify(points, tolerance),
+// define it before including geojsonvt (e.g. fast_rdp's geojsonvt.hpp)
 inline void simplify(std::vector<vt_point> &points, double tolerance)
 {
+#ifdef MAPBOX_GEOJSONVT_SIMPLIFY
+    MAPBOX_GEOJSONVT_SIMPLIFY(points, tolerance);
+#else
     const size_t len = points.size();
 
     // always retain the endpoints (1 is the max value)
@@ -87,6 +92,7 @@ inline void simplify(std::vector<vt_point> &points, double tolerance)
     points[len - 1].z = 1.0;
 
     simplify(points, 0, len - 1, tolerance * tolerance);
+#endif
 }
 
 } // namespace detail
@@ -0,0 +1,239 @@
+#ifndef FAST_RDP_CODEC_HPP
+#define FAST_RDP_CODEC_HPP
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+
+#ifdef FAST_RDP_WITH_ZLIB
+#include <gzip/compress.hpp>
+#include <gzip/decompress.hpp>
+#endif
+#include <gzip/utils.hpp>
+#include <protozero/buffer_string.hpp>
+#include <protozero/varint.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fast_rdp
+{
+// Compact encoding of (simplified) polylines:
+//
+//      "frdp" varint(version) varint(dims) double(resolution) varint(#lines)
+//      per line: varint(#points), per point & axis:
+//          zigzag varint(delta of round(value / resolution))
+//
+// deltas restart at each line (lines are encoded independently, in
+// parallel). The whole buffer may be gzipped, decode detects it (only if
+// built with zlib, see has_zlib).
+namespace codec
+{
+constexpr char magic[4] = {'f', 'r', 'd', 'p'};
+constexpr uint64_t version = 1;
+#ifdef FAST_RDP_WITH_ZLIB
+constexpr bool has_zlib = true;
+#else
+constexpr bool has_zlib = false;
+#endif
+
+inline std::runtime_error no_zlib()
+{
+    return std::runtime_error("gzip needs zlib, fast_rdp was built without");
+}
+
+inline void add_header(std::string &buffer, int dims, double resolution,
+                       uint64_t num_lines)
+{
+    if (!(resolution > 0.0)) {
+        throw std::invalid_argument("resolution should be positive");
+    }
+    buffer.append(magic, sizeof(magic));
+    protozero::add_varint_to_buffer(&buffer, version);
+    protozero::add_varint_to_buffer(&buffer, dims);
+    buffer.append(reinterpret_cast<const char *>(&resolution),
+                  sizeof(resolution));
+    protozero::add_varint_to_buffer(&buffer, num_lines);
+}
+
+inline int64_t quantize(double value, double resolution)
+{
+    const double q = std::round(value / resolution);
+    // keeps deltas in int64 range
+    if (!(std::fabs(q) < 4.0e18)) {
+        throw std::invalid_argument("coordinate " + std::to_string(value) +
+                                    " can't be quantized");
+    }
+    return static_cast<int64_t>(q);
+}
+
+// rows of coords where mask is set (all if no mask), without materializing
+// select_by_mask(coords, mask)
+template <typename Derived>
+void add_line(std::string &buffer, const Eigen::MatrixBase<Derived> &coords,
+              const Eigen::VectorXi *mask, double resolution)
+{
+    const int N = coords.rows(), dims = coords.cols();
+    if (mask && mask->size() != N) {
+        throw std::invalid_argument("mask size mismatch, " +
+                                    std::to_string(mask->size()) +
+                                    " != " + std::to_string(N));
+    }
+    protozero::add_varint_to_buffer(&buffer, mask ? mask->sum() : N);
+    int64_t cursor[3] = {0, 0, 0};
+    for (int i = 0; i < N; ++i) {
+        if (mask && !(*mask)[i]) {
+            continue;
+        }
+        for (int d = 0; d < dims; ++d) {
+            const int64_t v = quantize(coords(i, d), resolution);
+            protozero::add_varint_to_buffer(
+                &buffer, protozero::encode_zigzag64(v - cursor[d]));
+            cursor[d] = v;
+        }
+    }
+}
+
+inline std::string finish(std::string buffer, bool compress)
+{
+    if (!compress) {
+        return buffer;
+    }
+#ifdef FAST_RDP_WITH_ZLIB
+    return gzip::compress(buffer.data(), buffer.size());
+#else
+    throw no_zlib();
+#endif
+}
+} // namespace codec
+
+// encodes lines (Nx2 or Nx3), kept rows only if masks given (e.g. from
+// douglas_simplify_batch_masks), lines are encoded in parallel
+template <typename Coords>
+std::string encode_polylines(const std::vector<Coords> &lines,
+                             const std::vector<Eigen::VectorXi> *masks,
+                             double resolution, bool compress = false,
+                             int num_threads = 0)
+{
+    constexpr int dims = Coords::ColsAtCompileTime;
+    static_assert(dims == 2 || dims == 3, "Nx2 or Nx3 coords");
+    const int N = lines.size();
+    if (masks && static_cast<int>(masks->size()) != N) {
+        throw std::invalid_argument("#masks != #lines");
+    }
+    std::string buffer;
+    codec::add_header(buffer, dims, resolution, N);
+    std::vector<std::string> encoded(N);
+    parallel_for(
+        N,
+        [&](int i) {
+            const auto *mask = masks ? &(*masks)[i] : nullptr;
+            codec::add_line(encoded[i], lines[i], mask, resolution);
+        },
+        num_threads);
+    size_t size = buffer.size();
+    for (auto &e : encoded) {
+        size += e.size();
+    }
+    buffer.reserve(size);
+    for (auto &e : encoded) {
+        buffer += e;
+    }
+    return codec::finish(std::move(buffer), compress);
+}
+
+// single line, see encode_polylines
+template <typename Derived>
+std::string encode_polyline(const Eigen::MatrixBase<Derived> &coords,
+                            const Eigen::VectorXi *mask, double resolution,
+                            bool compress = false)
+{
+    std::string buffer;
+    codec::add_header(buffer, coords.cols(), resolution, 1);
+    codec::add_line(buffer, coords, mask, resolution);
+    return codec::finish(std::move(buffer), compress);
+}
+
+// decodes (gunzips if needed) lines as Nx3 (z = 0 if dims == 2)
+inline std::vector<RowVectors> decode_polylines(const std::string &bytes,
+                                                int *dims = nullptr)
+{
+    std::string decompressed;
+    const char *data = bytes.data();
+    const char *end = data + bytes.size();
+    if (gzip::is_compressed(data, bytes.size())) {
+#ifdef FAST_RDP_WITH_ZLIB
+        decompressed = gzip::decompress(data, bytes.size());
+        data = decompressed.data();
+        end = data + decompressed.size();
+#else
+        throw codec::no_zlib();
+#endif
+    }
+    auto invalid = [](const std::string &msg) {
+        return std::invalid_argument("invalid encoded polylines, " + msg);
+    };
+    if (end - data < 4 || std::memcmp(data, codec::magic, 4)) {
+        throw invalid("bad magic bytes");
+    }
+    data += 4;
+    std::vector<RowVectors> lines;
+    try {
+        if (protozero::decode_varint(&data, end) != codec::version) {
+            throw invalid("unknown version");
+        }
+        const int D = protozero::decode_varint(&data, end);
+        if (D != 2 && D != 3) {
+            throw invalid("bad dims: " + std::to_string(D));
+        }
+        if (dims) {
+            *dims = D;
+        }
+        double resolution;
+        if (end - data < static_cast<int>(sizeof(resolution))) {
+            throw invalid("truncated");
+        }
+        std::memcpy(&resolution, data, sizeof(resolution));
+        data += sizeof(resolution);
+        const uint64_t num_lines = protozero::decode_varint(&data, end);
+        // every line takes at least one byte
+        if (num_lines > static_cast<uint64_t>(end - data)) {
+            throw invalid("truncated");
+        }
+        lines.reserve(num_lines);
+        for (uint64_t l = 0; l < num_lines; ++l) {
+            const uint64_t N = protozero::decode_varint(&data, end);
+            // every coord takes at least one byte, N * D may overflow
+            if (N > static_cast<uint64_t>(end - data) / D ||
+                N > static_cast<uint64_t>(
+                        std::numeric_limits<Eigen::Index>::max())) {
+                throw invalid("truncated");
+            }
+            RowVectors &coords = lines.emplace_back(N, 3);
+            coords.setZero();
+            int64_t cursor[3] = {0, 0, 0};
+            for (uint64_t i = 0; i < N; ++i) {
+                for (int d = 0; d < D; ++d) {
+                    cursor[d] += protozero::decode_zigzag64(
+                        protozero::decode_varint(&data, end));
+                    coords(i, d) = cursor[d] * resolution;
+                }
+            }
+        }
+    } catch (const protozero::end_of_buffer_exception &) {
+        throw invalid("truncated");
+    } catch (const protozero::varint_too_long_exception &) {
+        throw invalid("bad varint");
+    }
+    if (data != end) {
+        throw invalid("trailing bytes");
+    }
+    return lines;
+}
+} // namespace fast_rdp
+
+#endif
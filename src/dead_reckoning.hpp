@@ -0,0 +1,189 @@
+#ifndef FAST_RDP_DEAD_RECKONING_HPP
+#define FAST_RDP_DEAD_RECKONING_HPP
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace fast_rdp
+{
+// Dead reckoning of tracks (x, y, t) or (x, y, z, t): a vertex is kept only
+// if its position deviates by more than epsilon (euclidean, as
+// LineSegment::distance, over x, y (, z)) from the position predicted from
+// the last kept vertex, A + v * (t - A_t). v is the velocity A was reached
+// at (from the vertex before it, 0 for the first vertex), so a receiver
+// knowing the kept vertices (and v) reconstructs every dropped position
+// within epsilon, in O(1) per vertex. The last vertex is always kept (see
+// finish()), the track ends there.
+template <int Dims = 3> class DeadReckoning
+{
+  public:
+    using Vector = Eigen::Matrix<double, Dims, 1>;
+    using Spatial = Eigen::Matrix<double, Dims - 1, 1>;
+    using Coords = Eigen::Matrix<double, Eigen::Dynamic, Dims, Eigen::RowMajor>;
+
+    explicit DeadReckoning(double epsilon) : epsilon2_(epsilon * epsilon)
+    {
+        if (!(epsilon >= 0)) {
+            throw std::invalid_argument("epsilon should be >= 0");
+        }
+    }
+
+    // squared deviation of P from its dead-reckoned position
+    static double deviation2(const Vector &key, const Spatial &velocity,
+                             const Vector &P)
+    {
+        const double dt = P[Dims - 1] - key[Dims - 1];
+        return ((P - key).template head<Dims - 1>() - dt * velocity)
+            .squaredNorm();
+    }
+    // velocity P was reached at from prev (0 if no time elapsed)
+    static Spatial velocity(const Vector &prev, const Vector &P)
+    {
+        const double dt = P[Dims - 1] - prev[Dims - 1];
+        if (!(dt > 0)) {
+            return Spatial::Zero();
+        }
+        return (P - prev).template head<Dims - 1>() / dt;
+    }
+
+    // next vertex, returns true if it is kept (see key(), velocity())
+    bool push(const Vector &P)
+    {
+        const bool kept =
+            count_ == 0 || deviation2(key_, velocity_, P) > epsilon2_;
+        if (kept) {
+            velocity_ = count_ == 0 ? Spatial::Zero() : velocity(prev_, P);
+            key_ = P;
+        }
+        before_ = prev_;
+        prev_ = P;
+        key_index_ = kept ? count_ : key_index_;
+        ++count_;
+        return kept;
+    }
+
+    // end of the track, keeps the last vertex: returns true if it was not
+    // kept yet (key() and velocity() are then updated)
+    bool finish()
+    {
+        if (count_ == 0 || key_index_ == count_ - 1) {
+            return false;
+        }
+        velocity_ = velocity(before_, prev_);
+        key_ = prev_;
+        key_index_ = count_ - 1;
+        return true;
+    }
+
+    const Vector &key() const { return key_; } // last kept vertex
+    const Spatial &velocity() const { return velocity_; }
+    int size() const { return count_; } // vertices pushed
+
+  private:
+    double epsilon2_;
+    int count_ = 0, key_index_ = -1;
+    Vector key_, prev_, before_;
+    Spatial velocity_ = Spatial::Zero();
+};
+
+// dead reckoning mask of a track, same as pushing its vertices to a
+// DeadReckoning, but the deviations from the last kept vertex are computed
+// for blocks of vertices at once (vectorized), the block doubles (up to
+// 1024) while no vertex in it is kept. The last vertex is kept (finish()).
+template <int Dims>
+Eigen::VectorXi dead_reckoning_mask(
+    const Eigen::Ref<const typename DeadReckoning<Dims>::Coords> &track,
+    double epsilon)
+{
+    using DR = DeadReckoning<Dims>;
+    if (!(epsilon >= 0)) {
+        throw std::invalid_argument("epsilon should be >= 0");
+    }
+    const int N = track.rows();
+    Eigen::VectorXi mask = Eigen::VectorXi::Zero(N);
+    if (N == 0) {
+        return mask;
+    }
+    constexpr int min_block = 8, max_block = 1024;
+    const double epsilon2 = epsilon * epsilon;
+    Eigen::VectorXd d2(std::min(N, max_block));
+    int key = 0, block = min_block;
+    typename DR::Spatial v = DR::Spatial::Zero();
+    mask[0] = 1;
+    for (int i = 1; i < N;) {
+        const int n = std::min(block, N - i);
+        auto rows = track.middleRows(i, n);
+        const auto A = track.row(key);
+        auto moved = rows.template leftCols<Dims - 1>().rowwise() -
+                     A.template head<Dims - 1>();
+        auto dt = (rows.col(Dims - 1).array() - A[Dims - 1]).matrix();
+        d2.head(n) = (moved - dt * v.transpose()).rowwise().squaredNorm();
+        int k = 0;
+        while (k < n && !(d2[k] > epsilon2)) {
+            ++k;
+        }
+        if (k == n) {
+            i += n;
+            block = std::min(2 * block, max_block);
+            continue;
+        }
+        key = i + k;
+        mask[key] = 1;
+        v = DR::velocity(track.row(key - 1), track.row(key));
+        i = key + 1;
+        block = min_block;
+    }
+    mask[N - 1] = 1;
+    return mask;
+}
+
+// velocities the kept vertices of track were reached at (DeadReckoning's
+// velocity()), one row per kept vertex: with the kept vertices, what a
+// receiver needs to predict the dropped ones
+template <int Dims>
+Eigen::Matrix<double, Eigen::Dynamic, Dims - 1, Eigen::RowMajor>
+dead_reckoning_velocities(
+    const Eigen::Ref<const typename DeadReckoning<Dims>::Coords> &track,
+    const Eigen::Ref<const Eigen::VectorXi> &mask)
+{
+    using DR = DeadReckoning<Dims>;
+    Eigen::Matrix<double, Eigen::Dynamic, Dims - 1, Eigen::RowMajor> ret(
+        mask.sum(), Dims - 1);
+    ret.setZero(); // the first vertex
+    for (int i = 0, k = 0, N = track.rows(); i < N; ++i) {
+        if (!mask[i]) {
+            continue;
+        }
+        if (i > 0) {
+            ret.row(k) = DR::velocity(track.row(i - 1), track.row(i));
+        }
+        ++k;
+    }
+    return ret;
+}
+
+// dead reckoning masks of tracks (Nx3 x, y, t or Nx4 x, y, z, t), in parallel
+template <int Dims>
+std::vector<Eigen::VectorXi> dead_reckoning_masks(
+    const std::vector<typename DeadReckoning<Dims>::Coords> &tracks,
+    double epsilon, int num_threads = 0)
+{
+    std::vector<Eigen::VectorXi> masks(tracks.size());
+    parallel_for(
+        tracks.size(),
+        [&](int l) {
+            trace::Scope scope("dead_reckoning", "dead_reckoning", l,
+                               tracks[l].rows());
+            masks[l] = dead_reckoning_mask<Dims>(tracks[l], epsilon);
+        },
+        num_threads);
+    return masks;
+}
+} // namespace fast_rdp
+
+#endif
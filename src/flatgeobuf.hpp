@@ -0,0 +1,979 @@
+#ifndef FAST_RDP_FLATGEOBUF_HPP
+#define FAST_RDP_FLATGEOBUF_HPP
+
+#include "network.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+#include <functional> // packedrtree.hpp uses std::function
+#include <mio.hpp>
+#include <packedrtree.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fast_rdp
+{
+// FlatGeobuf (https://flatgeobuf.org, v3): magic bytes, size-prefixed Header
+// flatbuffer, optional packed hilbert r-tree index, size-prefixed Feature
+// flatbuffers. There is no flatbuffers library in the tree, the (small, fixed)
+// schema is read and written by hand here.
+namespace flatgeobuf
+{
+enum GeometryType : uint8_t
+{
+    Unknown = 0,
+    Point = 1,
+    LineString = 2,
+    Polygon = 3,
+    MultiPoint = 4,
+    MultiLineString = 5,
+    MultiPolygon = 6,
+    GeometryCollection = 7,
+};
+
+// field ids, see header.fbs & feature.fbs
+struct Header
+{
+    enum : int
+    {
+        name,
+        envelope,
+        geometry_type,
+        has_z,
+        has_m,
+        has_t,
+        has_tm,
+        columns,
+        features_count,
+        index_node_size,
+        crs,
+        title,
+        description,
+        metadata,
+    };
+};
+struct Geometry
+{
+    enum : int
+    {
+        ends,
+        xy,
+        z,
+        m,
+        t,
+        tm,
+        type,
+        parts,
+    };
+};
+struct Feature
+{
+    enum : int
+    {
+        geometry,
+        properties,
+        columns,
+    };
+};
+
+constexpr uint8_t magic_bytes[8] = {'f', 'g', 'b', 3, 'f', 'g', 'b', 1};
+constexpr int max_depth = 64; // of nested geometries (parts)
+
+[[noreturn]] inline void invalid(const std::string &what)
+{
+    throw std::runtime_error("invalid FlatGeobuf " + what);
+}
+
+// flatbuffers data is little-endian and may be unaligned
+template <typename T> T read_scalar(const uint8_t *p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template <typename T> struct Vector
+{
+    const uint8_t *data = nullptr; // first element
+    uint32_t size = 0;
+    T operator[](uint32_t i) const
+    {
+        return read_scalar<T>(data + i * sizeof(T));
+    }
+};
+
+// bounds of a size-prefixed buffer (the size is checked by the Reader),
+// every offset read from the file is checked against them before use
+struct Bounds
+{
+    const uint8_t *begin = nullptr;
+    uint64_t size = 0; // with the size prefix
+
+    // begin + pos, if [pos, pos + n) is within the buffer
+    const uint8_t *at(int64_t pos, uint64_t n, const char *what) const
+    {
+        if (pos < 0 || uint64_t(pos) > size || size - pos < n) {
+            invalid(what);
+        }
+        return begin + pos;
+    }
+    // p + offset (read at p), n bytes there
+    const uint8_t *follow(const uint8_t *p, int64_t offset, uint64_t n,
+                          const char *what) const
+    {
+        return at((p - begin) + offset, n, what);
+    }
+};
+
+struct Table
+{
+    const uint8_t *data = nullptr;
+    Bounds bounds;
+
+    explicit operator bool() const { return data != nullptr; }
+    // nullptr if the field is not set, else its n bytes are in bounds
+    const uint8_t *field(int id, uint64_t n = 1) const
+    {
+        if (!data) {
+            return nullptr;
+        }
+        const uint8_t *vtable = bounds.follow(
+            data, -int64_t(read_scalar<int32_t>(data)), 4, "vtable offset");
+        const int at = 4 + 2 * id;
+        if (at + 2 > read_scalar<uint16_t>(vtable)) {
+            return nullptr;
+        }
+        uint16_t offset = read_scalar<uint16_t>(
+            bounds.follow(vtable, at, 2, "vtable size"));
+        return offset ? bounds.follow(data, offset, n, "field offset")
+                      : nullptr;
+    }
+    template <typename T> T scalar(int id, T default_value) const
+    {
+        const uint8_t *p = field(id, sizeof(T));
+        return p ? read_scalar<T>(p) : default_value;
+    }
+    // target of an offset field (string, vector, table)
+    const uint8_t *target(int id) const
+    {
+        const uint8_t *p = field(id, 4);
+        return p ? bounds.follow(p, read_scalar<uint32_t>(p), 4, "offset")
+                 : nullptr;
+    }
+    Table table(int id) const { return {target(id), bounds}; }
+    template <typename T> Vector<T> vector(int id) const
+    {
+        const uint8_t *p = target(id);
+        if (!p) {
+            return {};
+        }
+        const uint32_t size = read_scalar<uint32_t>(p);
+        bounds.follow(p, 4, uint64_t(size) * sizeof(T), "vector length");
+        return {p + 4, size};
+    }
+    // element i of a vector of tables
+    Table table(int id, uint32_t i) const
+    {
+        auto offsets = vector<uint32_t>(id);
+        if (i >= offsets.size) {
+            invalid("vector index");
+        }
+        const uint8_t *p = offsets.data + 4 * i;
+        return {bounds.follow(p, read_scalar<uint32_t>(p), 4, "offset"),
+                bounds};
+    }
+};
+
+// root table of a size-prefixed buffer
+inline Table root(const uint8_t *buffer)
+{
+    const Bounds bounds{buffer, 4 + uint64_t(read_scalar<uint32_t>(buffer))};
+    const uint8_t *p = bounds.at(4, 4, "root offset");
+    return {bounds.follow(p, read_scalar<uint32_t>(p), 4, "root offset"),
+            bounds};
+}
+
+// Writes a size-prefixed flatbuffer front to back: a table is written before
+// the objects it refers to (offsets always point forward), offset fields are
+// linked once their targets are written. Alignment is relative to the buffer
+// start, the buffer is padded to 8 bytes. A measuring builder only computes
+// the layout, size() is that of the buffer it would write.
+class Builder
+{
+  public:
+    explicit Builder(bool measure = false) : measure_(measure)
+    {
+        resize(8); // size prefix, root offset
+    }
+
+    bool measuring() const { return measure_; }
+    size_t size() const { return size_; }
+
+    template <typename T> void add_scalar(int id, T value)
+    {
+        Field f{id, sizeof(T), 0, 0};
+        std::memcpy(&f.bits, &value, sizeof(T));
+        fields_.push_back(f);
+    }
+    void add_offset(int id) { fields_.push_back({id, 4, 0, 0}); }
+    // writes vtable & table of the added fields, returns table position
+    size_t end_table()
+    {
+        int num_slots = 0;
+        for (auto &f : fields_) {
+            num_slots = std::max(num_slots, f.id + 1);
+        }
+        align(2);
+        const size_t vtable = size_;
+        const size_t vtable_size = 4 + 2 * num_slots;
+        const size_t table = (vtable + vtable_size + 7) / 8 * 8;
+        std::stable_sort(
+            fields_.begin(), fields_.end(),
+            [](const Field &a, const Field &b) { return a.size > b.size; });
+        size_t table_size = 4;
+        for (auto &f : fields_) {
+            table_size = (table_size + f.size - 1) / f.size * f.size;
+            f.pos = table + table_size;
+            table_size += f.size;
+        }
+        resize(table + table_size);
+        put<uint16_t>(vtable, vtable_size);
+        put<uint16_t>(vtable + 2, table_size);
+        for (auto &f : fields_) {
+            put<uint16_t>(vtable + 4 + 2 * f.id, f.pos - table);
+            copy(f.pos, &f.bits, f.size);
+        }
+        put<int32_t>(table, table - vtable);
+        last_fields_.swap(fields_);
+        fields_.clear();
+        return table;
+    }
+    // position of a field of the last table
+    size_t field(int id) const
+    {
+        for (auto &f : last_fields_) {
+            if (f.id == id) {
+                return f.pos;
+            }
+        }
+        throw std::logic_error("field not in table");
+    }
+    template <typename T> size_t vector(const Vector<T> &v)
+    {
+        return vector(v.data, v.size, sizeof(T));
+    }
+    template <typename T> size_t vector(const std::vector<T> &v)
+    {
+        return vector(reinterpret_cast<const uint8_t *>(v.data()), v.size(),
+                      sizeof(T));
+    }
+    // vector of n elements, zeroed, set() them
+    template <typename T> size_t vector(uint32_t n)
+    {
+        return vector(nullptr, n, sizeof(T));
+    }
+    template <typename T> void set(size_t vector, uint32_t i, T value)
+    {
+        put<T>(vector + 4 + i * sizeof(T), value);
+    }
+    // vector of n offsets, element i is at position + 4 + 4 * i
+    size_t vector_of_offsets(uint32_t n) { return vector<uint32_t>(n); }
+    // raw copy of another (size-prefixed) buffer, keeps its alignment
+    size_t append(const uint8_t *data, size_t size)
+    {
+        align(8);
+        size_t pos = size_;
+        resize(pos + size);
+        copy(pos, data, size);
+        return pos;
+    }
+    // offset at `at` -> `target`
+    void link(size_t at, size_t target) { put<uint32_t>(at, target - at); }
+    // the buffer (empty if measuring)
+    std::vector<uint8_t> finish(size_t root_table)
+    {
+        link(4, root_table);
+        align(8);
+        put<uint32_t>(0, size_ - 4);
+        return std::move(buffer_);
+    }
+
+  private:
+    struct Field
+    {
+        int id;
+        int size;
+        uint64_t bits;
+        size_t pos;
+    };
+    bool measure_;
+    size_t size_ = 0;
+    std::vector<uint8_t> buffer_;
+    std::vector<Field> fields_, last_fields_;
+
+    void resize(size_t size)
+    {
+        size_ = size;
+        if (!measure_) {
+            buffer_.resize(size, 0);
+        }
+    }
+    void align(size_t n) { resize((size_ + n - 1) / n * n); }
+    void copy(size_t pos, const void *data, size_t size)
+    {
+        if (!measure_ && size) {
+            std::memcpy(&buffer_[pos], data, size);
+        }
+    }
+    template <typename T> void put(size_t pos, T value)
+    {
+        copy(pos, &value, sizeof(T));
+    }
+    size_t vector(const uint8_t *data, uint32_t n, size_t element_size)
+    {
+        const size_t a = std::max<size_t>(element_size, 4);
+        resize((size_ + 4 + a - 1) / a * a - 4);
+        size_t pos = size_;
+        resize(pos + 4 + n * element_size);
+        put<uint32_t>(pos, n);
+        if (data) {
+            copy(pos + 4, data, n * element_size);
+        }
+        return pos;
+    }
+};
+
+inline GeometryType geometry_type(Table geometry, GeometryType parent)
+{
+    auto type = geometry.scalar<uint8_t>(Geometry::type, Unknown);
+    return type != Unknown ? GeometryType(type) : parent;
+}
+
+// vectors of a geometry are consistent with its xy vertices
+inline void check_geometry(Table geometry)
+{
+    const uint32_t size = geometry.vector<double>(Geometry::xy).size;
+    if (size % 2) {
+        invalid("geometry xy (odd length)");
+    }
+    for (int id : {Geometry::z, Geometry::m, Geometry::t}) {
+        if (geometry.vector<double>(id).size > size / 2) {
+            invalid("geometry z/m/t (longer than xy)");
+        }
+    }
+    if (geometry.vector<uint64_t>(Geometry::tm).size > size / 2) {
+        invalid("geometry tm (longer than xy)");
+    }
+    auto ends = geometry.vector<uint32_t>(Geometry::ends);
+    for (uint32_t i = 1; i < ends.size; ++i) {
+        if (ends[i] < ends[i - 1]) {
+            invalid("geometry ends (decreasing)");
+        }
+    }
+}
+
+// calls fn(geometry, type, first_vertex) for a geometry and its parts, depth
+// first. vertices (xy pairs) are numbered over the whole feature. Geometries
+// are checked (check_geometry) before fn sees them.
+template <typename Fn>
+void for_each_geometry(Table geometry, GeometryType type, Fn &&fn,
+                       size_t &vertex, int depth = 0)
+{
+    if (depth > max_depth) {
+        invalid("geometry (nested too deep)");
+    }
+    check_geometry(geometry);
+    fn(geometry, type, vertex);
+    vertex += geometry.vector<double>(Geometry::xy).size / 2;
+    const uint32_t num_parts = geometry.vector<uint32_t>(Geometry::parts).size;
+    const GeometryType part_type = type == MultiPolygon ? Polygon : Unknown;
+    for (uint32_t i = 0; i < num_parts; ++i) {
+        Table part = geometry.table(Geometry::parts, i);
+        for_each_geometry(part, geometry_type(part, part_type), fn, vertex,
+                          depth + 1);
+    }
+}
+
+// linear parts (lines, rings) of a geometry: [begin, end) in its xy vertices
+inline std::vector<std::pair<uint32_t, uint32_t>>
+linear_parts(Table geometry, GeometryType type)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> parts;
+    if (type != LineString && type != MultiLineString && type != Polygon) {
+        return parts;
+    }
+    const uint32_t N = geometry.vector<double>(Geometry::xy).size / 2;
+    auto ends = geometry.vector<uint32_t>(Geometry::ends);
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i < ends.size; ++i) {
+        const uint32_t end = std::min(ends[i], N); // ends are non-decreasing
+        parts.emplace_back(begin, end);
+        begin = end;
+    }
+    if (ends.size == 0 && N > 0) {
+        parts.emplace_back(0, N);
+    }
+    return parts;
+}
+
+// part of a geometry as Nx3 (z = 0 if there is no z)
+inline RowVectors part_coords(Table geometry,
+                              const std::pair<uint32_t, uint32_t> &part)
+{
+    auto xy = geometry.vector<double>(Geometry::xy);
+    auto z = geometry.vector<double>(Geometry::z);
+    RowVectors xyzs(part.second - part.first, 3);
+    for (uint32_t i = part.first, k = 0; i < part.second; ++i, ++k) {
+        xyzs(k, 0) = xy[2 * i];
+        xyzs(k, 1) = xy[2 * i + 1];
+        xyzs(k, 2) = i < z.size ? z[i] : 0.0;
+    }
+    return xyzs;
+}
+
+// which vertices of a feature to keep: linestrings & polygon rings are
+// simplified together (like simplify_geojson_geometry), other vertices kept
+inline std::vector<char> simplify_feature(Table feature, GeometryType type,
+                                          double epsilon, bool recursive,
+                                          DistanceMetric metric,
+                                          bool preserve_topology)
+{
+    std::vector<RowVectors> lines;
+    std::vector<size_t> firsts;
+    std::vector<char> rings;
+    size_t num_vertices = 0;
+    for_each_geometry(
+        feature.table(Feature::geometry), type,
+        [&](Table g, GeometryType t, size_t vertex) {
+            for (auto &part : linear_parts(g, t)) {
+                lines.push_back(part_coords(g, part));
+                firsts.push_back(vertex + part.first);
+                rings.push_back(t == Polygon);
+            }
+        },
+        num_vertices);
+    std::vector<char> keep(num_vertices, 1);
+    auto masks = douglas_simplify_batch_masks(lines, epsilon, recursive, metric,
+                                              false, preserve_topology, 1);
+    for (int i = 0, N = lines.size(); i < N; ++i) {
+        if (rings[i] && masks[i].sum() < 4) {
+            continue; // don't collapse rings
+        }
+        for (int k = 0, M = masks[i].size(); k < M; ++k) {
+            keep[firsts[i] + k] = masks[i][k];
+        }
+    }
+    return keep;
+}
+
+// bbox of kept vertices
+inline FlatGeobuf::NodeItem feature_bbox(Table feature, GeometryType type,
+                                         const std::vector<char> &keep)
+{
+    auto bbox = FlatGeobuf::NodeItem::create(0);
+    size_t num_vertices = 0;
+    for_each_geometry(
+        feature.table(Feature::geometry), type,
+        [&](Table g, GeometryType, size_t vertex) {
+            auto xy = g.vector<double>(Geometry::xy);
+            for (uint32_t i = 0; i < xy.size / 2; ++i) {
+                if (keep.empty() || keep[vertex + i]) {
+                    double x = xy[2 * i], y = xy[2 * i + 1];
+                    bbox.expand({x, y, x, y, 0});
+                }
+            }
+        },
+        num_vertices);
+    if (bbox.minX > bbox.maxX) {
+        bbox = {0.0, 0.0, 0.0, 0.0, 0}; // empty geometry
+    }
+    return bbox;
+}
+
+// vector of the elements of kept vertices
+template <typename T>
+size_t filter(Builder &b, const Vector<T> &v, const std::vector<char> &keep,
+              size_t first, int stride = 1)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < v.size; ++i) {
+        n += keep[first + i / stride];
+    }
+    const size_t pos = b.vector<T>(n);
+    if (b.measuring()) {
+        return pos;
+    }
+    for (uint32_t i = 0, k = 0; i < v.size; ++i) {
+        if (keep[first + i / stride]) {
+            b.set<T>(pos, k++, v[i]);
+        }
+    }
+    return pos;
+}
+
+// copy of a geometry with only kept vertices (ends adjusted), the geometry
+// is checked (for_each_geometry) already
+inline size_t write_geometry(Builder &b, Table g, GeometryType type,
+                             const std::vector<char> &keep, size_t &vertex)
+{
+    const size_t first = vertex;
+    const uint32_t N = g.vector<double>(Geometry::xy).size / 2;
+    vertex += N;
+    const int vectors[] = {Geometry::ends, Geometry::xy, Geometry::z,
+                           Geometry::m,    Geometry::t,  Geometry::tm,
+                           Geometry::parts};
+    for (int id : vectors) {
+        if (g.field(id)) {
+            b.add_offset(id);
+        }
+    }
+    if (g.field(Geometry::type)) {
+        b.add_scalar<uint8_t>(Geometry::type, g.scalar<uint8_t>(
+                                                  Geometry::type, Unknown));
+    }
+    const size_t table = b.end_table();
+    std::vector<size_t> fields(Geometry::parts + 1, 0);
+    for (int id : vectors) {
+        if (g.field(id)) {
+            fields[id] = b.field(id);
+        }
+    }
+    if (fields[Geometry::ends]) {
+        auto ends = g.vector<uint32_t>(Geometry::ends);
+        const size_t new_ends = b.vector<uint32_t>(ends.size);
+        uint32_t i = 0, num_kept = 0;
+        for (uint32_t k = 0; k < ends.size && !b.measuring(); ++k) {
+            for (; i < std::min(ends[k], N); ++i) {
+                num_kept += keep[first + i];
+            }
+            b.set<uint32_t>(new_ends, k, num_kept);
+        }
+        b.link(fields[Geometry::ends], new_ends);
+    }
+    if (fields[Geometry::xy]) {
+        b.link(fields[Geometry::xy],
+               filter(b, g.vector<double>(Geometry::xy), keep, first, 2));
+    }
+    for (int id : {Geometry::z, Geometry::m, Geometry::t}) {
+        if (fields[id]) {
+            b.link(fields[id], filter(b, g.vector<double>(id), keep, first));
+        }
+    }
+    if (fields[Geometry::tm]) {
+        b.link(fields[Geometry::tm],
+               filter(b, g.vector<uint64_t>(Geometry::tm), keep, first));
+    }
+    if (fields[Geometry::parts]) {
+        const uint32_t num_parts =
+            g.vector<uint32_t>(Geometry::parts).size;
+        const size_t parts = b.vector_of_offsets(num_parts);
+        b.link(fields[Geometry::parts], parts);
+        const GeometryType part_type = type == MultiPolygon ? Polygon : Unknown;
+        for (uint32_t i = 0; i < num_parts; ++i) {
+            Table part = g.table(Geometry::parts, i);
+            size_t pos = write_geometry(b, part, geometry_type(part, part_type),
+                                        keep, vertex);
+            b.link(parts + 4 + 4 * i, pos);
+        }
+    }
+    return table;
+}
+
+// size-prefixed Feature with simplified geometry, properties (and per
+// feature columns) are copied; empty (see b.size()) if b is measuring
+inline std::vector<uint8_t> write_feature(Builder &b, const uint8_t *buffer,
+                                          GeometryType type,
+                                          const std::vector<char> &keep)
+{
+    Table feature = root(buffer);
+    const int fields[] = {Feature::geometry, Feature::properties,
+                          Feature::columns};
+    for (int id : fields) {
+        if (feature.field(id)) {
+            b.add_offset(id);
+        }
+    }
+    const size_t table = b.end_table();
+    std::vector<size_t> pos(3, 0);
+    for (int id : fields) {
+        if (feature.field(id)) {
+            pos[id] = b.field(id);
+        }
+    }
+    if (pos[Feature::geometry]) {
+        size_t vertex = 0;
+        b.link(pos[Feature::geometry],
+               write_geometry(b, feature.table(Feature::geometry), type, keep,
+                              vertex));
+    }
+    if (pos[Feature::properties]) {
+        b.link(pos[Feature::properties],
+               b.vector(feature.vector<uint8_t>(Feature::properties)));
+    }
+    if (pos[Feature::columns]) {
+        // rare (per feature schema), copy the whole original feature
+        size_t base =
+            b.append(buffer, 4 + read_scalar<uint32_t>(buffer));
+        b.link(pos[Feature::columns],
+               base + (feature.target(Feature::columns) - buffer));
+    }
+    return b.finish(table);
+}
+
+inline std::vector<uint8_t> write_feature(const uint8_t *buffer,
+                                          GeometryType type,
+                                          const std::vector<char> &keep)
+{
+    Builder b;
+    return write_feature(b, buffer, type, keep);
+}
+
+// copy of a size-prefixed Header with features_count & index_node_size set,
+// the original header is appended and referred to (no need to know Column &
+// Crs tables)
+inline std::vector<uint8_t> write_header(const uint8_t *buffer,
+                                         uint64_t features_count,
+                                         uint16_t index_node_size)
+{
+    Builder b;
+    Table header = root(buffer);
+    const int offsets[] = {Header::name,        Header::envelope,
+                           Header::columns,     Header::crs,
+                           Header::title,       Header::description,
+                           Header::metadata};
+    const int flags[] = {Header::geometry_type, Header::has_z, Header::has_m,
+                         Header::has_t, Header::has_tm};
+    for (int id : offsets) {
+        if (header.field(id)) {
+            b.add_offset(id);
+        }
+    }
+    for (int id : flags) {
+        if (header.field(id)) {
+            b.add_scalar<uint8_t>(id, header.scalar<uint8_t>(id, 0));
+        }
+    }
+    b.add_scalar<uint64_t>(Header::features_count, features_count);
+    b.add_scalar<uint16_t>(Header::index_node_size, index_node_size);
+    const size_t table = b.end_table();
+    std::vector<std::pair<size_t, int>> links;
+    for (int id : offsets) {
+        if (header.field(id)) {
+            links.emplace_back(b.field(id), id);
+        }
+    }
+    const size_t base = b.append(buffer, 4 + read_scalar<uint32_t>(buffer));
+    for (auto &link : links) {
+        b.link(link.first, base + (header.target(link.second) - buffer));
+    }
+    return b.finish(table);
+}
+
+// header of a file of LineString features
+inline std::vector<uint8_t>
+linestring_header(uint64_t features_count, uint16_t index_node_size, bool has_z,
+                  const FlatGeobuf::NodeItem &extent)
+{
+    Builder b;
+    b.add_offset(Header::envelope);
+    b.add_scalar<uint8_t>(Header::geometry_type, LineString);
+    b.add_scalar<uint8_t>(Header::has_z, has_z);
+    b.add_scalar<uint64_t>(Header::features_count, features_count);
+    b.add_scalar<uint16_t>(Header::index_node_size, index_node_size);
+    const size_t table = b.end_table();
+    const size_t envelope = b.field(Header::envelope);
+    std::vector<double> bounds = {extent.minX, extent.minY, extent.maxX,
+                                  extent.maxY};
+    b.link(envelope, b.vector(bounds));
+    return b.finish(table);
+}
+
+// size-prefixed LineString feature (no properties), empty (see b.size()) if
+// b is measuring
+inline std::vector<uint8_t>
+linestring_feature(Builder &b, const Eigen::Ref<const RowVectors> &coords,
+                   bool has_z)
+{
+    b.add_offset(Feature::geometry);
+    size_t table = b.end_table();
+    const size_t geometry = b.field(Feature::geometry);
+    b.add_offset(Geometry::xy);
+    if (has_z) {
+        b.add_offset(Geometry::z);
+    }
+    b.link(geometry, b.end_table());
+    const size_t xy = b.field(Geometry::xy);
+    const size_t z = has_z ? b.field(Geometry::z) : 0;
+    const int N = coords.rows();
+    const size_t xys = b.vector<double>(2 * N);
+    for (int i = 0; i < N && !b.measuring(); ++i) {
+        b.set<double>(xys, 2 * i, coords(i, 0));
+        b.set<double>(xys, 2 * i + 1, coords(i, 1));
+    }
+    b.link(xy, xys);
+    if (has_z) {
+        const size_t zs = b.vector<double>(N);
+        for (int i = 0; i < N && !b.measuring(); ++i) {
+            b.set<double>(zs, i, coords(i, 2));
+        }
+        b.link(z, zs);
+    }
+    return b.finish(table);
+}
+
+inline std::vector<uint8_t>
+linestring_feature(const Eigen::Ref<const RowVectors> &coords, bool has_z)
+{
+    Builder b;
+    return linestring_feature(b, coords, has_z);
+}
+
+// A FlatGeobuf file, memory-mapped. Features are not parsed, offsets into the
+// mapping are collected once.
+class Reader
+{
+  public:
+    explicit Reader(const std::string &path) : mmap_(path)
+    {
+        const uint8_t *data = this->data();
+        const size_t size = mmap_.size();
+        if (size < 12 || std::memcmp(data, magic_bytes, 3) ||
+            data[3] != magic_bytes[3] ||
+            std::memcmp(data + 4, magic_bytes, 3)) {
+            throw std::runtime_error("not a FlatGeobuf (v3) file: " + path);
+        }
+        header_ = data + 8;
+        size_t pos = 12 + read_scalar<uint32_t>(header_);
+        if (pos > size) {
+            throw std::runtime_error("truncated FlatGeobuf file: " + path);
+        }
+        Table header = root(header_);
+        type_ = GeometryType(
+            header.scalar<uint8_t>(Header::geometry_type, Unknown));
+        const uint64_t count =
+            header.scalar<uint64_t>(Header::features_count, 0);
+        const uint16_t node_size =
+            header.scalar<uint16_t>(Header::index_node_size, 16);
+        if (node_size == 1) {
+            invalid("header (index_node_size 1)");
+        }
+        if (node_size > 0 && count > 0) {
+            // a feature takes at least one node (40 bytes)
+            if (count > size) {
+                throw std::runtime_error("truncated FlatGeobuf file: " +
+                                         path);
+            }
+            pos += FlatGeobuf::PackedRTree::size(count, node_size);
+        }
+        while (pos + 4 <= size) {
+            const size_t next = pos + 4 + read_scalar<uint32_t>(data + pos);
+            if (next > size) {
+                throw std::runtime_error("truncated FlatGeobuf file: " + path);
+            }
+            features_.push_back(data + pos);
+            pos = next;
+        }
+    }
+
+    const uint8_t *data() const
+    {
+        return reinterpret_cast<const uint8_t *>(mmap_.data());
+    }
+    const uint8_t *header() const { return header_; }
+    GeometryType header_type() const { return type_; }
+    bool has_z() const
+    {
+        return root(header_).scalar<uint8_t>(Header::has_z, 0);
+    }
+    // size-prefixed Feature buffers, in file order
+    const std::vector<const uint8_t *> &features() const { return features_; }
+    // effective geometry type of feature (header type, unless Unknown)
+    GeometryType type(const uint8_t *feature) const
+    {
+        return geometry_type(root(feature).table(Feature::geometry), type_);
+    }
+
+  private:
+    mio::mmap_source mmap_;
+    const uint8_t *header_ = nullptr;
+    GeometryType type_ = Unknown;
+    std::vector<const uint8_t *> features_;
+};
+
+// Writes magic bytes, header, index (if index_node_size > 0, features are
+// sorted by the hilbert value of their bbox, like FlatGeobuf writers do) and
+// features. encode(i) returns the size-prefixed buffer of feature i, features
+// are encoded in parallel, in batches of `window`.
+template <typename Encode>
+void write_file(const std::string &path, const std::vector<uint8_t> &header,
+                std::vector<FlatGeobuf::NodeItem> bboxes,
+                const std::vector<uint64_t> &sizes, uint16_t index_node_size,
+                Encode &&encode, int window = 1024, int num_threads = 0)
+{
+    std::unique_ptr<FILE, int (*)(FILE *)> file(
+        std::fopen(path.c_str(), "wb"), &std::fclose);
+    if (!file) {
+        throw std::runtime_error("failed to open " + path);
+    }
+    auto write = [&](const void *data, size_t size) {
+        if (std::fwrite(data, 1, size, file.get()) != size) {
+            throw std::runtime_error("failed to write " + path);
+        }
+    };
+    write(magic_bytes, sizeof(magic_bytes));
+    write(header.data(), header.size());
+
+    const size_t N = bboxes.size();
+    std::vector<size_t> order(N);
+    for (size_t i = 0; i < N; ++i) {
+        order[i] = i;
+    }
+    if (index_node_size > 0 && N > 0) {
+        for (size_t i = 0; i < N; ++i) {
+            bboxes[i].offset = i;
+        }
+        FlatGeobuf::hilbertSort(bboxes);
+        uint64_t offset = 0;
+        for (size_t i = 0; i < N; ++i) {
+            order[i] = bboxes[i].offset;
+            bboxes[i].offset = offset;
+            offset += sizes[order[i]];
+        }
+        FlatGeobuf::PackedRTree tree(bboxes, FlatGeobuf::calcExtent(bboxes),
+                                     index_node_size);
+        tree.streamWrite(
+            [&](uint8_t *data, size_t size) { write(data, size); });
+    }
+    for (size_t begin = 0; begin < N; begin += window) {
+        const size_t end = std::min(N, begin + window);
+        std::vector<std::vector<uint8_t>> buffers(end - begin);
+        parallel_for(
+            end - begin,
+            [&](int i) { buffers[i] = encode(order[begin + i]); }, num_threads);
+        for (auto &buffer : buffers) {
+            write(buffer.data(), buffer.size());
+        }
+    }
+}
+} // namespace flatgeobuf
+
+// Simplifies linestrings & polygon rings of a FlatGeobuf file into a new
+// FlatGeobuf file. The input is memory-mapped and read in place (no parsing
+// into intermediate objects), features are simplified in parallel, then
+// written with a rebuilt packed r-tree index (index=false: no index, input
+// order). Properties, columns, crs etc. are copied as is. Returns the number
+// of features.
+inline int simplify_flatgeobuf(const std::string &input_path,
+                               const std::string &output_path, double epsilon,
+                               bool recursive, DistanceMetric metric,
+                               bool preserve_topology, bool index = true,
+                               int num_threads = 0)
+{
+    using namespace flatgeobuf;
+    Reader reader(input_path);
+    const auto &features = reader.features();
+    const int N = features.size();
+    // pass 1: kept vertices, bboxes & sizes (for the index)
+    std::vector<std::vector<char>> keeps(N);
+    std::vector<FlatGeobuf::NodeItem> bboxes(N);
+    std::vector<uint64_t> sizes(N);
+    parallel_for(
+        N,
+        [&](int i) {
+            trace::Scope scope(recursive ? "recursive" : "iterative",
+                               "flatgeobuf", i);
+            const uint8_t *buffer = features[i];
+            const GeometryType type = reader.type(buffer);
+            Table feature = root(buffer);
+            keeps[i] = simplify_feature(feature, type, epsilon, recursive,
+                                        metric, preserve_topology);
+            bboxes[i] = feature_bbox(feature, type, keeps[i]);
+            // layout only, features are written in pass 2
+            Builder measure(true);
+            write_feature(measure, buffer, type, keeps[i]);
+            sizes[i] = measure.size();
+        },
+        num_threads);
+    const uint16_t node_size = index && N > 0 ? 16 : 0;
+    write_file(
+        output_path, write_header(reader.header(), N, node_size), bboxes,
+        sizes, node_size,
+        [&](size_t i) {
+            return write_feature(features[i], reader.type(features[i]),
+                                 keeps[i]);
+        },
+        1024, num_threads);
+    return N;
+}
+
+// Writes lines (Nx3, has_z: keep z) as a FlatGeobuf file of LineString
+// features, with a packed r-tree index (features in hilbert order) if index.
+inline void write_flatgeobuf(const std::string &path,
+                             const std::vector<RowVectors> &lines, bool has_z,
+                             bool index = true, int num_threads = 0)
+{
+    using namespace flatgeobuf;
+    const int N = lines.size();
+    std::vector<FlatGeobuf::NodeItem> bboxes(N);
+    std::vector<uint64_t> sizes(N);
+    auto extent = FlatGeobuf::NodeItem::create(0);
+    for (int i = 0; i < N; ++i) {
+        auto &bbox = bboxes[i];
+        bbox = FlatGeobuf::NodeItem::create(0);
+        for (int k = 0; k < lines[i].rows(); ++k) {
+            double x = lines[i](k, 0), y = lines[i](k, 1);
+            bbox.expand({x, y, x, y, 0});
+        }
+        if (bbox.minX > bbox.maxX) {
+            bbox = {0.0, 0.0, 0.0, 0.0, 0};
+        }
+        extent.expand(bbox);
+        Builder measure(true);
+        linestring_feature(measure, lines[i], has_z);
+        sizes[i] = measure.size();
+    }
+    const uint16_t node_size = index && N > 0 ? 16 : 0;
+    write_file(path, linestring_header(N, node_size, has_z, extent), bboxes,
+               sizes, node_size,
+               [&](size_t i) { return linestring_feature(lines[i], has_z); },
+               1024, num_threads);
+}
+
+// Reads linear parts of features: for each feature (in file order), its
+// lines / rings / points (one Nx3 array per part, z = 0 if not has_z).
+inline std::vector<std::vector<RowVectors>>
+read_flatgeobuf(const std::string &path, bool &has_z)
+{
+    using namespace flatgeobuf;
+    Reader reader(path);
+    has_z = reader.has_z();
+    std::vector<std::vector<RowVectors>> ret;
+    ret.reserve(reader.features().size());
+    for (const uint8_t *buffer : reader.features()) {
+        auto &parts = ret.emplace_back();
+        size_t num_vertices = 0;
+        for_each_geometry(
+            root(buffer).table(Feature::geometry), reader.type(buffer),
+            [&](Table g, GeometryType t, size_t) {
+                const uint32_t N = g.vector<double>(Geometry::xy).size / 2;
+                auto linear = linear_parts(g, t);
+                if (linear.empty() && N > 0) {
+                    linear.emplace_back(0, N); // points
+                }
+                for (auto &part : linear) {
+                    parts.push_back(part_coords(g, part));
+                }
+            },
+            num_vertices);
+    }
+    return ret;
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,404 @@
+#ifndef FAST_RDP_GEOJSON_HPP
+#define FAST_RDP_GEOJSON_HPP
+
+#include "network.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/filewritestream.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fast_rdp
+{
+// geojson positions -> Nx3 (z = 0 for 2d positions), false if `positions` is
+// not an array of positions
+inline bool geojson_coords(const rapidjson::Value &positions, RowVectors &xyzs)
+{
+    if (!positions.IsArray()) {
+        return false;
+    }
+    xyzs.resize(positions.Size(), 3);
+    for (rapidjson::SizeType i = 0; i < positions.Size(); ++i) {
+        const auto &p = positions[i];
+        if (!p.IsArray() || p.Size() < 2 || !p[0].IsNumber() ||
+            !p[1].IsNumber()) {
+            return false;
+        }
+        xyzs(i, 0) = p[0].GetDouble();
+        xyzs(i, 1) = p[1].GetDouble();
+        xyzs(i, 2) = p.Size() > 2 && p[2].IsNumber() ? p[2].GetDouble() : 0.0;
+    }
+    return true;
+}
+
+// collects coordinates arrays of linear parts of a geometry (linestrings and
+// polygon rings), points are left out
+inline void geojson_lines(rapidjson::Value &geometry,
+                          std::vector<rapidjson::Value *> &lines,
+                          std::vector<char> &rings)
+{
+    if (!geometry.IsObject()) {
+        return;
+    }
+    auto type = geometry.FindMember("type");
+    if (type == geometry.MemberEnd() || !type->value.IsString()) {
+        return;
+    }
+    const std::string t = type->value.GetString();
+    if (t == "GeometryCollection") {
+        auto geometries = geometry.FindMember("geometries");
+        if (geometries != geometry.MemberEnd() &&
+            geometries->value.IsArray()) {
+            for (auto &g : geometries->value.GetArray()) {
+                geojson_lines(g, lines, rings);
+            }
+        }
+        return;
+    }
+    auto coords = geometry.FindMember("coordinates");
+    if (coords == geometry.MemberEnd() || !coords->value.IsArray()) {
+        return;
+    }
+    auto add = [&](rapidjson::Value &line, bool ring) {
+        lines.push_back(&line);
+        rings.push_back(ring);
+    };
+    auto &c = coords->value;
+    if (t == "LineString") {
+        add(c, false);
+    } else if (t == "MultiLineString" || t == "Polygon") {
+        for (auto &part : c.GetArray()) {
+            add(part, t == "Polygon");
+        }
+    } else if (t == "MultiPolygon") {
+        for (auto &polygon : c.GetArray()) {
+            if (polygon.IsArray()) {
+                for (auto &ring : polygon.GetArray()) {
+                    add(ring, true);
+                }
+            }
+        }
+    }
+}
+
+// Simplifies linestrings & polygon rings of a geojson geometry in place.
+// Parts are simplified together (preserve_topology: they don't cross each
+// other). Rings are kept as is if they would collapse (< 4 points), malformed
+// geometries are left untouched.
+inline void simplify_geojson_geometry(
+    rapidjson::Value &geometry, rapidjson::Document::AllocatorType &allocator,
+    double epsilon, bool recursive, DistanceMetric metric,
+    bool preserve_topology)
+{
+    std::vector<rapidjson::Value *> parts;
+    std::vector<char> rings;
+    geojson_lines(geometry, parts, rings);
+    std::vector<RowVectors> lines(parts.size());
+    for (int i = 0, N = parts.size(); i < N; ++i) {
+        if (!geojson_coords(*parts[i], lines[i])) {
+            return;
+        }
+    }
+    auto masks = douglas_simplify_batch_masks(lines, epsilon, recursive, metric,
+                                              false, preserve_topology, 1);
+    for (int i = 0, N = parts.size(); i < N; ++i) {
+        auto &mask = masks[i];
+        int num_kept = mask.sum();
+        if (num_kept == mask.size() || (rings[i] && num_kept < 4)) {
+            continue;
+        }
+        auto &positions = *parts[i];
+        rapidjson::Value kept(rapidjson::kArrayType);
+        kept.Reserve(num_kept, allocator);
+        for (int j = 0, M = mask.size(); j < M; ++j) {
+            if (mask[j]) {
+                kept.PushBack(positions[j], allocator); // moved
+            }
+        }
+        positions.Swap(kept);
+    }
+}
+
+// SAX handler for everything but the features: copies events to the writer,
+// flags where a feature (object in top-level "features" array) starts and
+// where the features array ends, the caller handles them.
+template <typename Writer> struct GeoJSONEnvelopeHandler
+{
+    using Ch = typename Writer::Ch;
+
+    Writer &writer;
+    int depth = 0;
+    bool features_key = false;
+    int features_depth = -1; // depth of items in features array
+    bool feature_begin = false;
+    bool features_end = false;
+
+    explicit GeoJSONEnvelopeHandler(Writer &writer) : writer(writer) {}
+
+    bool Null() { return value() && writer.Null(); }
+    bool Bool(bool b) { return value() && writer.Bool(b); }
+    bool Int(int i) { return value() && writer.Int(i); }
+    bool Uint(unsigned u) { return value() && writer.Uint(u); }
+    bool Int64(int64_t i) { return value() && writer.Int64(i); }
+    bool Uint64(uint64_t u) { return value() && writer.Uint64(u); }
+    bool Double(double d) { return value() && writer.Double(d); }
+    bool RawNumber(const Ch *str, rapidjson::SizeType len, bool copy)
+    {
+        return value() && writer.RawNumber(str, len, copy);
+    }
+    bool String(const Ch *str, rapidjson::SizeType len, bool copy)
+    {
+        return value() && writer.String(str, len, copy);
+    }
+    bool Key(const Ch *str, rapidjson::SizeType len, bool copy)
+    {
+        features_key = depth == 1 && std::string(str, len) == "features";
+        return writer.Key(str, len, copy);
+    }
+    bool StartObject()
+    {
+        if (depth == features_depth) {
+            feature_begin = true;
+            return true;
+        }
+        features_key = false;
+        ++depth;
+        return writer.StartObject();
+    }
+    bool EndObject(rapidjson::SizeType count)
+    {
+        --depth;
+        return writer.EndObject(count);
+    }
+    bool StartArray()
+    {
+        bool is_features = depth == 1 && features_key && features_depth < 0;
+        if (!value()) {
+            return false;
+        }
+        ++depth;
+        if (is_features) {
+            features_depth = depth;
+        }
+        return writer.StartArray();
+    }
+    bool EndArray(rapidjson::SizeType count)
+    {
+        if (depth == features_depth) {
+            features_depth = -1;
+            features_end = true;
+            --depth;
+            return true;
+        }
+        --depth;
+        return writer.EndArray(count);
+    }
+
+  private:
+    // features must be objects
+    bool value()
+    {
+        features_key = false;
+        return depth != features_depth;
+    }
+};
+
+// SAX handler forwarding one json value (a feature) to a document
+template <typename Handler> struct GeoJSONFeatureHandler
+{
+    using Ch = typename Handler::Ch;
+
+    Handler &handler;
+    int depth = 0;
+
+    bool Null() { return handler.Null(); }
+    bool Bool(bool b) { return handler.Bool(b); }
+    bool Int(int i) { return handler.Int(i); }
+    bool Uint(unsigned u) { return handler.Uint(u); }
+    bool Int64(int64_t i) { return handler.Int64(i); }
+    bool Uint64(uint64_t u) { return handler.Uint64(u); }
+    bool Double(double d) { return handler.Double(d); }
+    bool RawNumber(const Ch *str, rapidjson::SizeType len, bool copy)
+    {
+        return handler.RawNumber(str, len, copy);
+    }
+    bool String(const Ch *str, rapidjson::SizeType len, bool copy)
+    {
+        return handler.String(str, len, copy);
+    }
+    bool Key(const Ch *str, rapidjson::SizeType len, bool copy)
+    {
+        return handler.Key(str, len, copy);
+    }
+    bool StartObject()
+    {
+        ++depth;
+        return handler.StartObject();
+    }
+    bool EndObject(rapidjson::SizeType count)
+    {
+        --depth;
+        return handler.EndObject(count);
+    }
+    bool StartArray()
+    {
+        ++depth;
+        return handler.StartArray();
+    }
+    bool EndArray(rapidjson::SizeType count)
+    {
+        --depth;
+        return handler.EndArray(count);
+    }
+};
+
+// Streams a GeoJSON FeatureCollection from `is` to `os`, simplifying the
+// geometries of features.
+//
+// The input is pulled token by token (rapidjson::Reader, iterative parsing),
+// only features are parsed into documents. Features are handed over in
+// batches of `window` features: a batch is simplified & serialized by up to
+// num_threads workers and written out (in input order) while the next batch
+// is being parsed, so at most two batches are in memory. Everything else
+// (members of the collection, other top-level json) is copied as is. Returns
+// the number of features.
+template <typename InputStream, typename OutputStream>
+int simplify_geojson(InputStream &is, OutputStream &os, double epsilon,
+                     bool recursive, DistanceMetric metric,
+                     bool preserve_topology, int window = 1024,
+                     int num_threads = 0)
+{
+    if (window < 1) {
+        throw std::invalid_argument("window should be >= 1");
+    }
+    using Writer = rapidjson::Writer<OutputStream>;
+    constexpr unsigned flags = rapidjson::kParseFullPrecisionFlag;
+    Writer writer(os);
+    GeoJSONEnvelopeHandler<Writer> envelope(writer);
+    rapidjson::Reader reader;
+    std::vector<rapidjson::Document> batch;
+    std::future<void> pending; // destroyed (waited for) first
+    auto flush = [&]() {
+        if (pending.valid()) {
+            pending.get();
+        }
+        if (batch.empty()) {
+            return;
+        }
+        pending = std::async(std::launch::async, [&, features = std::move(
+                                                         batch)]() mutable {
+            const int N = features.size();
+            std::vector<rapidjson::StringBuffer> buffers(N);
+            parallel_for(
+                N,
+                [&](int i) {
+                    trace::Scope scope(recursive ? "recursive" : "iterative",
+                                       "geojson", i);
+                    auto &feature = features[i];
+                    auto geometry = feature.FindMember("geometry");
+                    if (geometry != feature.MemberEnd()) {
+                        simplify_geojson_geometry(
+                            geometry->value, feature.GetAllocator(), epsilon,
+                            recursive, metric, preserve_topology);
+                    }
+                    rapidjson::Writer<rapidjson::StringBuffer> w(buffers[i]);
+                    feature.Accept(w);
+                },
+                num_threads);
+            for (auto &buffer : buffers) {
+                writer.RawValue(buffer.GetString(), buffer.GetSize(),
+                                rapidjson::kObjectType);
+            }
+        });
+        batch.clear();
+    };
+    auto parse_feature = [&](rapidjson::Document &doc) {
+        GeoJSONFeatureHandler<rapidjson::Document> handler{doc, 1};
+        if (!doc.StartObject()) {
+            return false;
+        }
+        while (handler.depth > 0) {
+            if (!reader.IterativeParseNext<flags>(is, handler)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    int num_features = 0;
+    reader.IterativeParseInit();
+    while (!reader.IterativeParseComplete()) {
+        if (!reader.IterativeParseNext<flags>(is, envelope)) {
+            break;
+        }
+        if (envelope.feature_begin) {
+            envelope.feature_begin = false;
+            batch.emplace_back();
+            batch.back().Populate(parse_feature);
+            if (reader.HasParseError()) {
+                break;
+            }
+            ++num_features;
+            if ((int)batch.size() >= window) {
+                flush();
+            }
+        } else if (envelope.features_end) {
+            envelope.features_end = false;
+            flush();
+            flush(); // wait for the last batch
+            writer.EndArray();
+        }
+    }
+    if (reader.HasParseError()) {
+        std::string msg = reader.GetParseErrorCode() ==
+                                  rapidjson::kParseErrorTermination
+                              ? "features should be objects"
+                              : rapidjson::GetParseError_En(
+                                    reader.GetParseErrorCode());
+        throw std::runtime_error("invalid geojson at offset " +
+                                 std::to_string(reader.GetErrorOffset()) +
+                                 ": " + msg);
+    }
+    os.Flush();
+    return num_features;
+}
+
+// file to file version of simplify_geojson
+inline int simplify_geojson(const std::string &input_path,
+                            const std::string &output_path, double epsilon,
+                            bool recursive, DistanceMetric metric,
+                            bool preserve_topology, int window = 1024,
+                            int num_threads = 0)
+{
+    using File = std::unique_ptr<FILE, int (*)(FILE *)>;
+    File input(std::fopen(input_path.c_str(), "rb"), &std::fclose);
+    if (!input) {
+        throw std::runtime_error("failed to open " + input_path);
+    }
+    File output(std::fopen(output_path.c_str(), "wb"), &std::fclose);
+    if (!output) {
+        throw std::runtime_error("failed to open " + output_path);
+    }
+    std::vector<char> read_buffer(1 << 16), write_buffer(1 << 16);
+    rapidjson::FileReadStream is(input.get(), read_buffer.data(),
+                                 read_buffer.size());
+    rapidjson::FileWriteStream os(output.get(), write_buffer.data(),
+                                  write_buffer.size());
+    return simplify_geojson(is, os, epsilon, recursive, metric,
+                            preserve_topology, window, num_threads);
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef FAST_RDP_GEOJSONVT_HPP
+#define FAST_RDP_GEOJSONVT_HPP
+
+// include this before any <mapbox/geojsonvt*.hpp>, so geojsonvt simplifies
+// with the rdp core (see MAPBOX_GEOJSONVT_SIMPLIFY)
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+
+#include <mapbox/geojsonvt/types.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace fast_rdp
+{
+using VtPoint = mapbox::geojsonvt::detail::vt_point;
+
+// Drop-in for mapbox::geojsonvt::detail::simplify (same output): xy distances
+// are scanned by the rdp core, vt_point::z (geojsonvt's "importance" in
+// squared tile units) is filled by douglas_importance.
+inline void geojsonvt_simplify(std::vector<VtPoint> &points, double tolerance)
+{
+    const int N = points.size();
+    if (N == 0) {
+        return;
+    }
+    RowVectors xyzs(N, 3);
+    Eigen::VectorXd importance(N);
+    for (int i = 0; i < N; ++i) {
+        xyzs.row(i) << points[i].x, points[i].y, 0.0;
+        importance[i] = points[i].z;
+    }
+    // always retain the endpoints (1 is the max value)
+    importance[0] = importance[N - 1] = 1.0;
+    douglas_importance(xyzs, importance, 0, N - 1, tolerance * tolerance,
+                       HorizontalMetric(), false);
+    for (int i = 0; i < N; ++i) {
+        points[i].z = importance[i];
+    }
+}
+} // namespace fast_rdp
+
+#define MAPBOX_GEOJSONVT_SIMPLIFY ::fast_rdp::geojsonvt_simplify
+#include <mapbox/geojsonvt.hpp>
+
+namespace fast_rdp
+{
+namespace vt = mapbox::geojsonvt;
+
+// mapbox::geojsonvt::GeoJSONVT (same options, same tiles), built in parallel:
+// features are converted (projected & simplified) in parallel, and the tile
+// pyramid is split level by level, all tiles of a zoom level are built in
+// parallel, then their quadrants are clipped in parallel.
+// tile() may be called from several threads, drilling down is serialized.
+class GeoJSONVT
+{
+  public:
+    const vt::Options options;
+    const int num_threads;
+
+    GeoJSONVT(const vt::feature_collection &features,
+              const vt::Options &options = vt::Options(), int num_threads = 0)
+        : options(options), num_threads(num_threads)
+    {
+        const uint32_t z2 = 1u << options.maxZoom;
+        auto converted =
+            convert(features, (options.tolerance / options.extent) / z2);
+        auto wrapped = vt::detail::wrap(
+            converted, double(options.buffer) / options.extent,
+            options.lineMetrics);
+        split_tile(std::move(wrapped), 0, 0, 0);
+    }
+
+    GeoJSONVT(const vt::geojson &geojson,
+              const vt::Options &options = vt::Options(), int num_threads = 0)
+        : GeoJSONVT(vt::geojson::visit(geojson, vt::ToFeatureCollection{}),
+                    options, num_threads)
+    {
+    }
+
+    // tiles built per zoom level & in total (copies, see tile())
+    std::map<uint8_t, uint32_t> stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+    uint32_t total() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_;
+    }
+
+    // same as GeoJSONVT::getTile, drills down from the closest parent. z & y
+    // are checked before narrowing, x wraps around. The returned tile stays
+    // valid (the index only grows, its nodes never move).
+    const vt::Tile &tile(int z, int64_t x_, int64_t y_)
+    {
+        if (z < 0) {
+            throw std::runtime_error("Requested zoom is negative: " +
+                                     std::to_string(z));
+        }
+        if (z > options.maxZoom) {
+            throw std::runtime_error("Requested zoom higher than maxZoom: " +
+                                     std::to_string(z));
+        }
+        const int64_t z2 = int64_t(1) << z;
+        if (y_ < 0 || y_ >= z2) {
+            throw std::runtime_error("Requested y out of range at zoom " +
+                                     std::to_string(z) + ": " +
+                                     std::to_string(y_));
+        }
+        // wrap tile x coordinate
+        const uint32_t x = static_cast<uint32_t>(((x_ % z2) + z2) % z2);
+        const uint32_t y = static_cast<uint32_t>(y_);
+        const uint64_t id = vt::toID(z, x, y);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tiles_.find(id);
+        if (it != tiles_.end()) {
+            return it->second.tile;
+        }
+        it = find_parent(z, x, y);
+        if (it == tiles_.end()) {
+            throw std::runtime_error("Parent tile not found");
+        }
+        const auto &parent = it->second;
+        split_tile(parent.source_features, parent.z, parent.x, parent.y, z, x,
+                   y);
+        it = tiles_.find(id);
+        if (it != tiles_.end()) {
+            return it->second.tile;
+        }
+        return vt::empty_tile;
+    }
+
+    // z/x/y of the tiles built so far, sorted
+    std::vector<std::tuple<int, int, int>> tile_ids() const
+    {
+        std::vector<std::tuple<int, int, int>> ids;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ids.reserve(tiles_.size());
+            for (const auto &pair : tiles_) {
+                const auto &tile = pair.second;
+                ids.emplace_back(tile.z, tile.x, tile.y);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+  private:
+    // guards tiles_, stats_ & total_ (split_tile), once constructed
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, vt::detail::InternalTile> tiles_;
+    std::map<uint8_t, uint32_t> stats_;
+    uint32_t total_ = 0;
+
+    vt::detail::vt_features convert(const vt::feature_collection &features,
+                                    double tolerance) const
+    {
+        // chunks are converted in parallel, then concatenated in order
+        const int N = features.size();
+        const int num_chunks = resolve_num_threads(num_threads, N) * 4;
+        const int chunk_size = (N + num_chunks - 1) / num_chunks;
+        std::vector<vt::detail::vt_features> chunks(num_chunks);
+        parallel_for(
+            num_chunks,
+            [&](int c) {
+                auto &chunk = chunks[c];
+                for (int i = c * chunk_size,
+                         end = std::min(N, (c + 1) * chunk_size);
+                     i < end; ++i) {
+                    const auto &feature = features[i];
+                    vt::detail::identifier id = feature.id;
+                    if (options.generateId) {
+                        id = {uint64_t(i)};
+                    }
+                    chunk.emplace_back(
+                        vt::geometry::visit(feature.geometry,
+                                            vt::detail::project{tolerance}),
+                        feature.properties, id);
+                }
+            },
+            num_threads);
+        vt::detail::vt_features converted;
+        converted.reserve(N);
+        for (auto &chunk : chunks) {
+            std::move(chunk.begin(), chunk.end(),
+                      std::back_inserter(converted));
+        }
+        return converted;
+    }
+
+    std::unordered_map<uint64_t, vt::detail::InternalTile>::iterator
+    find_parent(uint8_t z, uint32_t x, uint32_t y)
+    {
+        auto parent = tiles_.end();
+        while (parent == tiles_.end() && z != 0) {
+            --z;
+            x /= 2;
+            y /= 2;
+            parent = tiles_.find(vt::toID(z, x, y));
+        }
+        return parent;
+    }
+
+    struct Task
+    {
+        vt::detail::vt_features features;
+        uint8_t z;
+        uint32_t x, y;
+    };
+
+    // GeoJSONVT::splitTile, breadth first: stop conditions are the same (cz
+    // == 0: first-pass tiling, else drilling down to tile cz/cx/cy). Called
+    // with mutex_ held (or from the constructor).
+    void split_tile(vt::detail::vt_features features, uint8_t z, uint32_t x,
+                    uint32_t y, uint8_t cz = 0, uint32_t cx = 0,
+                    uint32_t cy = 0)
+    {
+        std::vector<Task> level;
+        level.push_back({std::move(features), z, x, y});
+        while (!level.empty()) {
+            const int N = level.size();
+            std::vector<vt::detail::InternalTile *> tiles(N, nullptr);
+            for (int i = 0; i < N; ++i) {
+                auto it = tiles_.find(vt::toID(level[i].z, level[i].x,
+                                               level[i].y));
+                if (it != tiles_.end()) {
+                    tiles[i] = &it->second;
+                }
+            }
+            // new tiles are built (transformed & simplified) in parallel
+            std::vector<std::unique_ptr<vt::detail::InternalTile>> built(N);
+            parallel_for(
+                N,
+                [&](int i) {
+                    if (tiles[i]) {
+                        return;
+                    }
+                    const auto &task = level[i];
+                    const double z2 = 1u << task.z;
+                    const double tolerance =
+                        task.z == options.maxZoom
+                            ? 0
+                            : options.tolerance / (z2 * options.extent);
+                    built[i] = std::make_unique<vt::detail::InternalTile>(
+                        task.features, task.z, task.x, task.y, options.extent,
+                        tolerance, options.lineMetrics);
+                },
+                num_threads);
+            std::vector<int> to_split;
+            for (int i = 0; i < N; ++i) {
+                auto &task = level[i];
+                if (built[i]) {
+                    // unordered_map never moves its nodes, pointers stay valid
+                    tiles[i] = &tiles_
+                                    .emplace(vt::toID(task.z, task.x, task.y),
+                                             std::move(*built[i]))
+                                    .first->second;
+                    ++stats_[task.z];
+                    ++total_;
+                }
+                if (task.features.empty()) {
+                    continue;
+                }
+                if (should_split(*tiles[i], task, cz, cx, cy)) {
+                    to_split.push_back(i);
+                } else if (cz == 0u || task.z != options.maxZoom) {
+                    tiles[i]->source_features = std::move(task.features);
+                }
+            }
+
+            // quadrants: clip by x (2 halves), then by y (4 quadrants)
+            const int S = to_split.size();
+            std::vector<vt::detail::vt_features> halves(S * 2);
+            parallel_for(
+                S * 2,
+                [&](int k) {
+                    const auto &task = level[to_split[k / 2]];
+                    const auto &tile = *tiles[to_split[k / 2]];
+                    const double z2 = 1u << task.z;
+                    const double p = 0.5 * options.buffer / options.extent;
+                    const double x0 = task.x + (k % 2) * 0.5;
+                    halves[k] = vt::detail::clip<0>(
+                        task.features, (x0 - p) / z2, (x0 + 0.5 + p) / z2,
+                        tile.bbox.min.x, tile.bbox.max.x, options.lineMetrics);
+                },
+                num_threads);
+            std::vector<Task> next(S * 4);
+            parallel_for(
+                S * 4,
+                [&](int k) {
+                    const auto &task = level[to_split[k / 4]];
+                    const auto &tile = *tiles[to_split[k / 4]];
+                    const double z2 = 1u << task.z;
+                    const double p = 0.5 * options.buffer / options.extent;
+                    const int dx = (k / 2) % 2, dy = k % 2;
+                    const double y0 = task.y + dy * 0.5;
+                    next[k].features = vt::detail::clip<1>(
+                        halves[k / 2], (y0 - p) / z2, (y0 + 0.5 + p) / z2,
+                        tile.bbox.min.y, tile.bbox.max.y, options.lineMetrics);
+                    next[k].z = task.z + 1;
+                    next[k].x = task.x * 2 + dx;
+                    next[k].y = task.y * 2 + dy;
+                },
+                num_threads);
+            for (int i : to_split) {
+                // sliced further down, no need to keep source geometry
+                tiles[i]->source_features = {};
+            }
+            level = std::move(next);
+        }
+    }
+
+    bool should_split(const vt::detail::InternalTile &tile, const Task &task,
+                      uint8_t cz, uint32_t cx, uint32_t cy) const
+    {
+        if (cz == 0u) {
+            // first-pass tiling: stop at index max zoom or if simple enough
+            return task.z != options.indexMaxZoom &&
+                   tile.tile.num_points > options.indexMaxPoints;
+        }
+        // drilling down: stop at max zoom, at the target zoom or if the tile
+        // is not an ancestor of the target
+        if (task.z == options.maxZoom || task.z == cz) {
+            return false;
+        }
+        const double m = 1u << (cz - task.z);
+        return task.x == static_cast<uint32_t>(std::floor(cx / m)) &&
+               task.y == static_cast<uint32_t>(std::floor(cy / m));
+    }
+};
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef FAST_RDP_INTEGER_HPP
+#define FAST_RDP_INTEGER_HPP
+
+#include "rdp.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace fast_rdp
+{
+// integer (tile/quantized) 2d coords, int32 or int16
+template <typename Int>
+using IntRowVectorsNx2 = Eigen::Matrix<Int, Eigen::Dynamic, 2, Eigen::RowMajor>;
+
+// |coords| of the integer engine, so that squared distances & dot products of
+// differences fit in int64
+constexpr int64_t max_integer_coord = (int64_t(1) << 30) - 1;
+
+// unsigned 128-bit value, for products of two squared distances
+struct Wide
+{
+    uint64_t hi, lo;
+    bool operator<(const Wide &other) const
+    {
+        return hi < other.hi || (hi == other.hi && lo < other.lo);
+    }
+    bool operator==(const Wide &other) const
+    {
+        return hi == other.hi && lo == other.lo;
+    }
+    bool operator<=(const Wide &other) const { return !(other < *this); }
+
+    static constexpr Wide max() { return {UINT64_MAX, UINT64_MAX}; }
+    // floor(this / 2^n)
+    Wide shift_right(int n) const
+    {
+        if (n >= 128) {
+            return {0, 0};
+        } else if (n >= 64) {
+            return {0, hi >> (n - 64)};
+        } else if (n == 0) {
+            return *this;
+        }
+        return {hi >> n, (lo >> n) | (hi << (64 - n))};
+    }
+    // this * 2^n, max() if it overflows
+    Wide shift_left(int n) const
+    {
+        if (n == 0 || (hi == 0 && lo == 0)) {
+            return *this;
+        }
+        if (n >= 128 || max().shift_right(n) < *this) {
+            return max();
+        } else if (n >= 64) {
+            return {lo << (n - 64), 0};
+        }
+        return {(hi << n) | (lo >> (64 - n)), lo << n};
+    }
+};
+
+inline Wide multiply(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+    return {static_cast<uint64_t>(p >> 64), static_cast<uint64_t>(p)};
+#else
+    // 32-bit halves, e.g. msvc
+    const uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+    const uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+    const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    const uint64_t mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    return {p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32),
+            (mid << 32) | (p00 & 0xffffffff)};
+#endif
+}
+
+// epsilon^2 (the double epsilon * epsilon, as rdp compares to) exactly, as
+// mantissa * 2^exponent, an integer mantissa of at most 53 bits
+struct Epsilon2
+{
+    uint64_t mantissa;
+    int exponent;
+    explicit Epsilon2(double epsilon) : mantissa(0), exponent(0)
+    {
+        if (!(epsilon >= 0)) {
+            throw std::invalid_argument("epsilon should be >= 0");
+        }
+        const double epsilon2 = epsilon * epsilon;
+        if (std::isinf(epsilon2)) {
+            mantissa = 1;
+            exponent = 128; // saturates
+        } else if (epsilon2 > 0) {
+            const double fraction = std::frexp(epsilon2, &exponent);
+            mantissa = static_cast<uint64_t>(std::ldexp(fraction, 53));
+            exponent -= 53;
+        }
+    }
+};
+
+// distance to segment AB (as LineSegment) of integer points, exact: distance2
+// returns the squared distance times len2 (max(len2, 1)), an integer, the
+// same scale for every P, so distances to one segment compare exactly
+struct IntegerSegment
+{
+    int64_t ax, ay, bx, by, abx, aby;
+    uint64_t len2;
+    IntegerSegment(int64_t ax, int64_t ay, int64_t bx, int64_t by)
+        : ax(ax), ay(ay), bx(bx), by(by), abx(bx - ax), aby(by - ay),
+          len2(abx * abx + aby * aby)
+    {
+    }
+    static uint64_t norm2(int64_t x, int64_t y) { return x * x + y * y; }
+    Wide distance2(int64_t px, int64_t py) const
+    {
+        const int64_t apx = px - ax, apy = py - ay;
+        if (len2 == 0) {
+            return {0, norm2(apx, apy)};
+        }
+        const int64_t dot = apx * abx + apy * aby;
+        if (dot <= 0) {
+            return multiply(norm2(apx, apy), len2);
+        } else if (static_cast<uint64_t>(dot) >= len2) {
+            return multiply(norm2(px - bx, py - by), len2);
+        }
+        // (AB x AP)^2 / len2
+        const uint64_t cross = std::llabs(abx * apy - aby * apx);
+        return multiply(cross, cross);
+    }
+    // floor(epsilon^2 * len2), on the scale of distance2: as distance2 is an
+    // integer, distance2 <= threshold2 iff distance^2 <= epsilon^2 (exactly)
+    Wide threshold2(const Epsilon2 &epsilon2) const
+    {
+        const Wide scaled = multiply(epsilon2.mantissa, len2 ? len2 : 1);
+        return epsilon2.exponent < 0 ? scaled.shift_right(-epsilon2.exponent)
+                                     : scaled.shift_left(epsilon2.exponent);
+    }
+};
+// rdp of int32/int16 2d coords (segment metric) without floats in the scan:
+// squared distances, dot and cross products in int64, their products with
+// len2 in 128 bits, compared exactly to epsilon^2 (threshold2). Deterministic
+// on every platform, same mask as douglas_simplify_mask on the coords as
+// doubles (up to its rounding of near ties), a half (int32) or a quarter
+// (int16) of its memory traffic.
+// Coords should be within +-max_integer_coord.
+template <typename Int, typename Stats>
+Eigen::VectorXi douglas_simplify_integer_mask(
+    const Eigen::Ref<const IntRowVectorsNx2<Int>> &coords, double epsilon,
+    Stats &stats)
+{
+    const Epsilon2 epsilon2(epsilon);
+    const int N = coords.rows();
+    if (N > 0 && (coords.minCoeff() < -max_integer_coord ||
+                  coords.maxCoeff() > max_integer_coord)) {
+        throw std::invalid_argument(
+            "integer coords should be within +-(2^30 - 1)");
+    }
+    Eigen::VectorXi mask(N);
+    mask.setZero();
+    stats.allocated(mask.size() * sizeof(int));
+    if (N == 0) {
+        return mask;
+    }
+    using Span = std::pair<int, int>;
+    auto allocator = stats.template allocator<Span>();
+    std::vector<Span, decltype(allocator)> stack(allocator);
+    stack.push_back({0, N - 1});
+    while (!stack.empty()) {
+        const int i = stack.back().first;
+        const int j = stack.back().second;
+        stack.pop_back();
+        mask[i] = mask[j] = 1;
+        if (j - i <= 1 || stats.expired()) {
+            continue;
+        }
+        stats.scan(j - i - 1);
+        // farthest point, ties broken as in farthest_point
+        IntegerSegment segment(coords(i, 0), coords(i, 1), coords(j, 0),
+                               coords(j, 1));
+        Wide max_dist2{0, 0};
+        int max_index = i;
+        const int mid = i + (j - i) / 2;
+        int min_pos_to_mid = j - i;
+        bool expired = false;
+        for (int k = i + 1; k < j; ++k) {
+            if constexpr (Stats::has_deadline) {
+                if ((k - i) % Deadline::check_interval == 0 &&
+                    stats.expired()) {
+                    expired = true;
+                    break;
+                }
+            }
+            const Wide dist2 = segment.distance2(coords(k, 0), coords(k, 1));
+            if (max_dist2 < dist2) {
+                max_dist2 = dist2;
+                max_index = k;
+            } else if (dist2 == max_dist2) {
+                int pos_to_mid = std::abs(k - mid);
+                if (pos_to_mid < min_pos_to_mid) {
+                    min_pos_to_mid = pos_to_mid;
+                    max_index = k;
+                }
+            }
+        }
+        if (expired || max_dist2 <= segment.threshold2(epsilon2)) {
+            continue;
+        }
+        stack.push_back({max_index, j});
+        stack.push_back({i, max_index});
+        stats.queued(stack.size());
+    }
+    return mask;
+}
+
+template <typename Int>
+Eigen::VectorXi douglas_simplify_integer_mask(
+    const Eigen::Ref<const IntRowVectorsNx2<Int>> &coords, double epsilon)
+{
+    NoStats stats;
+    return douglas_simplify_integer_mask<Int>(coords, epsilon, stats);
+}
+} // namespace fast_rdp
+
+#endif
@@ -8,177 +8,339 @@
 #include <pybind11/eigen.h>
 #include <pybind11/iostream.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
-#include <queue>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+#include "integer.hpp"
+#include "pybind11_codec.hpp"
+#include "pybind11_dead_reckoning.hpp"
+#include "pybind11_flatgeobuf.hpp"
+#include "pybind11_geojson.hpp"
+#include "pybind11_geojsonvt.hpp"
+#include "pybind11_multires.hpp"
+#include "pybind11_network.hpp"
+#include "pybind11_simplification_error.hpp"
+#include "pybind11_sleeve.hpp"
+#include "pybind11_squish.hpp"
+#include "pybind11_trace.hpp"
+#include "rdp.hpp"
+#include "topology.hpp"
+
+// non-inline definitions of mapbox::geojson::parse/stringify, once per module
+#include <mapbox/geojson_impl.hpp>
 
 #define STRINGIFY(x) #x
 #define MACRO_STRINGIFY(x) STRINGIFY(x)
 
-struct LineSegment
+namespace py = pybind11;
+using namespace pybind11::literals;
+using namespace fast_rdp;
+
+// time budget of a call, expired: partial output (partial) or Cancelled
+struct Budget
 {
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-    const Eigen::Vector3d A, B, AB;
-    const double len2, inv_len2;
-    LineSegment(const Eigen::Vector3d &a, const Eigen::Vector3d &b)
-        : A(a), B(b), AB(b - a), //
-          len2((b - a).squaredNorm()), inv_len2(1.0 / len2)
-    {
+    Deadline deadline;
+    bool partial;
+};
+
+// simplify(hooks), a core instantiated with the hooks needed: NoStats unless
+// stats or a budget are given
+template <typename Simplify>
+Eigen::VectorXi with_hooks(RdpStats *stats, Budget *budget,
+                           const Simplify &simplify)
+{
+    NoStats none;
+    if (!budget) {
+        return stats ? simplify(*stats) : simplify(none);
     }
-    double distance2(const Eigen::Vector3d &P) const
-    {
-        double dot = (P - A).dot(AB);
-        if (dot <= 0) {
-            return (P - A).squaredNorm();
-        } else if (dot >= len2) {
-            return (P - B).squaredNorm();
+    Eigen::VectorXi mask;
+    if (stats) {
+        WithDeadline<RdpStats> hooks{*stats, budget->deadline};
+        mask = simplify(hooks);
+    } else {
+        WithDeadline<NoStats> hooks{none, budget->deadline};
+        mask = simplify(hooks);
+    }
+    if (budget->deadline.fired()) {
+        if (!budget->partial) {
+            throw Cancelled("rdp cancelled (timeout or cancellation token)");
+        }
+        if (stats) {
+            stats->cancelled = true;
         }
-        // P' = A + dot/length * normed(AB)
-        //    = A + dot * AB / (length^2)
-        return (A + (dot * inv_len2 * AB) - P).squaredNorm();
     }
-    double distance(const Eigen::Vector3d &P) const
-    {
-        return std::sqrt(distance2(P));
+    return mask;
+}
+
+template <typename Metric>
+Eigen::VectorXi simplify_mask(const CoordsRef<Metric> &coords, double epsilon,
+                              bool recursive, bool approximate,
+                              const Metric &metric, RdpStats *stats,
+                              Budget *budget)
+{
+    return with_hooks(stats, budget, [&](auto &hooks) {
+        return approximate ? douglas_simplify_approx_mask(coords, epsilon,
+                                                          metric, hooks)
+                           : douglas_simplify_mask(coords, epsilon, recursive,
+                                                   metric, hooks);
+    });
+}
+
+Eigen::VectorXi rdp_mask(const Eigen::Ref<const RowVectors> &coords,
+                         double epsilon, bool recursive, bool approximate,
+                         const std::string &metric,
+                         const std::optional<double> &epsilon_xy,
+                         const std::optional<double> &epsilon_z,
+                         bool topology, RdpStats *stats = nullptr,
+                         Budget *budget = nullptr)
+{
+    auto simplify = [&](double epsilon, const auto &policy) {
+        Eigen::VectorXi mask = simplify_mask(coords, epsilon, recursive,
+                                             approximate, policy, stats,
+                                             budget);
+        if (topology) {
+            preserve_topology(coords, mask, policy);
+        }
+        if (stats) {
+            stats->kept = mask.sum();
+        }
+        return mask;
+    };
+    auto dist = distance_metric(metric);
+    if (!epsilon_xy && !epsilon_z) {
+        return dispatch_metric(dist, [&](const auto &policy) {
+            return simplify(epsilon, policy);
+        });
     }
-};
+    if (dist != DistanceMetric::Segment) {
+        throw std::invalid_argument(
+            "epsilon_xy/epsilon_z only work with 'segment' metric");
+    }
+    const double inf = std::numeric_limits<double>::infinity();
+    return simplify(1.0, AnisotropicMetric(epsilon_xy.value_or(inf),
+                                           epsilon_z.value_or(inf)));
+}
 
-using RowVectors = Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>;
-using RowVectorsNx3 = RowVectors;
-using RowVectorsNx2 = Eigen::Matrix<double, Eigen::Dynamic, 2, Eigen::RowMajor>;
+Eigen::VectorXi rdp_mask(const Eigen::Ref<const RowVectorsNx2> &coords,
+                         double epsilon, bool recursive, bool approximate,
+                         const std::string &metric,
+                         const std::optional<double> &epsilon_xy,
+                         const std::optional<double> &epsilon_z,
+                         bool topology, RdpStats *stats = nullptr,
+                         Budget *budget = nullptr)
+{
+    const RowVectors xyzs = to_Nx3(coords, distance_metric(metric));
+    const size_t bytes = xyzs.size() * sizeof(double);
+    if (stats) {
+        stats->allocated(bytes);
+    }
+    auto mask = rdp_mask(Eigen::Ref<const RowVectors>(xyzs), epsilon,
+                         recursive, approximate, metric, epsilon_xy,
+                         epsilon_z, topology, stats, budget);
+    if (stats) {
+        stats->freed(bytes);
+    }
+    return mask;
+}
 
-void douglas_simplify(const Eigen::Ref<const RowVectors> &coords,
-                      Eigen::VectorXi &to_keep, const int i, const int j,
-                      const double epsilon)
+// trajectories with z, (x, y, z, t): only the 'sed' metric
+Eigen::VectorXi rdp_mask(const Eigen::Ref<const RowVectorsNx4> &coords,
+                         double epsilon, bool recursive, bool approximate,
+                         const std::string &metric,
+                         const std::optional<double> &epsilon_xy,
+                         const std::optional<double> &epsilon_z,
+                         bool topology, RdpStats *stats = nullptr,
+                         Budget *budget = nullptr)
 {
-    to_keep[i] = to_keep[j] = 1;
-    if (j - i <= 1) {
-        return;
+    if (distance_metric(metric) != DistanceMetric::Sed) {
+        throw std::invalid_argument(
+            "Nx4 coords (x, y, z, t) only work with 'sed' metric");
     }
-    LineSegment line(coords.row(i), coords.row(j));
-    double max_dist2 = 0.0;
-    int max_index = i;
-    int mid = i + (j - i) / 2;
-    int min_pos_to_mid = j - i;
-    for (int k = i + 1; k < j; ++k) {
-        double dist2 = line.distance2(coords.row(k));
-        if (dist2 > max_dist2) {
-            max_dist2 = dist2;
-            max_index = k;
-        } else if (dist2 == max_dist2) {
-            // a workaround to ensure we choose a pivot close to the middle of
-            // the list, reducing recursion depth, for certain degenerate inputs
-            // https://github.com/mapbox/geojson-vt/issues/104
-            int pos_to_mid = std::fabs(k - mid);
-            if (pos_to_mid < min_pos_to_mid) {
-                min_pos_to_mid = pos_to_mid;
-                max_index = k;
-            }
-        }
+    if (epsilon_xy || epsilon_z || topology) {
+        throw std::invalid_argument("epsilon_xy/epsilon_z/preserve_topology "
+                                    "don't work with Nx4 coords");
     }
-    if (max_dist2 <= epsilon * epsilon) {
-        return;
+    Eigen::VectorXi mask = simplify_mask(coords, epsilon, recursive,
+                                         approximate, SedMetric4{}, stats,
+                                         budget);
+    if (stats) {
+        stats->kept = mask.sum();
     }
-    douglas_simplify(coords, to_keep, i, max_index, epsilon);
-    douglas_simplify(coords, to_keep, max_index, j, epsilon);
+    return mask;
 }
 
-void douglas_simplify_iter(const Eigen::Ref<const RowVectors> &coords,
-                           Eigen::VectorXi &to_keep, const double epsilon)
+// whether int32/int16 coords go to the exact integer engine: 'segment'
+// metric, no other option, within +-max_integer_coord. Else they are
+// simplified as float64, as any integer coords were before it.
+template <typename Int>
+bool integer_engine(const Eigen::Ref<const IntRowVectorsNx2<Int>> &coords,
+                    bool approximate, const std::string &metric,
+                    const std::optional<double> &epsilon_xy,
+                    const std::optional<double> &epsilon_z, bool topology)
 {
-    std::queue<std::pair<int, int>> q;
-    q.push({0, to_keep.size() - 1});
-    while (!q.empty()) {
-        int i = q.front().first;
-        int j = q.front().second;
-        q.pop();
-        to_keep[i] = to_keep[j] = 1;
-        if (j - i <= 1) {
-            continue;
-        }
-        LineSegment line(coords.row(i), coords.row(j));
-        double max_dist2 = 0.0;
-        int max_index = i;
-        int mid = i + (j - i) / 2;
-        int min_pos_to_mid = j - i;
-        for (int k = i + 1; k < j; ++k) {
-            double dist2 = line.distance2(coords.row(k));
-            if (dist2 > max_dist2) {
-                max_dist2 = dist2;
-                max_index = k;
-            } else if (dist2 == max_dist2) {
-                // a workaround to ensure we choose a pivot close to the middle
-                // of the list, reducing recursion depth, for certain degenerate
-                // inputs https://github.com/mapbox/geojson-vt/issues/104
-                int pos_to_mid = std::fabs(k - mid);
-                if (pos_to_mid < min_pos_to_mid) {
-                    min_pos_to_mid = pos_to_mid;
-                    max_index = k;
-                }
-            }
+    if (distance_metric(metric) != DistanceMetric::Segment || epsilon_xy ||
+        epsilon_z || topology || approximate) {
+        return false;
+    }
+    return coords.rows() == 0 || (coords.minCoeff() >= -max_integer_coord &&
+                                  coords.maxCoeff() <= max_integer_coord);
+}
+
+// int32/int16 tile coords: the exact integer engine (see integer_engine)
+template <typename Int>
+Eigen::VectorXi rdp_mask(const Eigen::Ref<const IntRowVectorsNx2<Int>> &coords,
+                         double epsilon, bool recursive, bool approximate,
+                         const std::string &metric,
+                         const std::optional<double> &epsilon_xy,
+                         const std::optional<double> &epsilon_z,
+                         bool topology, RdpStats *stats = nullptr,
+                         Budget *budget = nullptr)
+{
+    if (!integer_engine<Int>(coords, approximate, metric, epsilon_xy,
+                             epsilon_z, topology)) {
+        const RowVectorsNx2 xys = coords.template cast<double>();
+        const size_t bytes = xys.size() * sizeof(double);
+        if (stats) {
+            stats->allocated(bytes);
         }
-        if (max_dist2 <= epsilon * epsilon) {
-            continue;
+        auto mask = rdp_mask(Eigen::Ref<const RowVectorsNx2>(xys), epsilon,
+                             recursive, approximate, metric, epsilon_xy,
+                             epsilon_z, topology, stats, budget);
+        if (stats) {
+            stats->freed(bytes);
         }
-        q.push({i, max_index});
-        q.push({max_index, j});
+        return mask;
     }
+    Eigen::VectorXi mask = with_hooks(stats, budget, [&](auto &hooks) {
+        return douglas_simplify_integer_mask<Int>(coords, epsilon, hooks);
+    });
+    if (stats) {
+        stats->kept = mask.sum();
+    }
+    return mask;
 }
 
-Eigen::VectorXi
-douglas_simplify_mask(const Eigen::Ref<const RowVectors> &coords,
-                      double epsilon, bool recursive)
+inline std::optional<Budget>
+make_budget(const std::optional<double> &timeout,
+            const CancellationToken *cancel, const std::string &on_timeout)
 {
-    Eigen::VectorXi mask(coords.rows());
-    mask.setZero();
-    if (recursive) {
-        douglas_simplify(coords, mask, 0, mask.size() - 1, epsilon);
-    } else {
-        douglas_simplify_iter(coords, mask, epsilon);
+    if (on_timeout != "partial" && on_timeout != "raise") {
+        throw std::invalid_argument("invalid on_timeout: '" + on_timeout +
+                                    "', should be 'partial' or 'raise'");
     }
-    return mask;
+    if (!timeout && !cancel) {
+        return std::nullopt;
+    }
+    return Budget{Deadline(timeout.value_or(-1.0), cancel),
+                  on_timeout == "partial"};
 }
 
-Eigen::VectorXi mask2indexes(const Eigen::Ref<const Eigen::VectorXi> &mask)
+// result, or (result, stats) if return_stats
+template <typename Result>
+py::object with_stats(Result &&result, const RdpStats *stats)
 {
-    Eigen::VectorXi indexes(mask.sum());
-    for (int i = 0, j = 0, N = mask.size(); i < N; ++i) {
-        if (mask[i]) {
-            indexes[j++] = i;
-        }
+    py::object ret = py::cast(std::forward<Result>(result));
+    if (!stats) {
+        return ret;
     }
-    return indexes;
+    return py::make_tuple(ret, *stats);
 }
 
-Eigen::VectorXi
-douglas_simplify_indexes(const Eigen::Ref<const RowVectors> &coords,
-                         double epsilon, bool recursive)
+// cancel=None loads in pybind11's no-convert pass (a pointer argument would
+// defer None to the convert pass, where overloads are tried in order)
+inline const CancellationToken *token(const py::object &cancel)
 {
-    return mask2indexes(douglas_simplify_mask(coords, epsilon, recursive));
+    return cancel.is_none() ? nullptr
+                            : cancel.cast<const CancellationToken *>();
 }
 
-RowVectors select_by_mask(const Eigen::Ref<const RowVectors> &coords,
-                          const Eigen::Ref<const Eigen::VectorXi> &mask)
+// simplified coords (same type), or (coords, stats) if return_stats
+template <typename Coords>
+py::object rdp_coords(const Eigen::Ref<const Coords> &coords, double epsilon,
+                      bool recursive, const std::string &metric,
+                      std::optional<double> epsilon_xy,
+                      std::optional<double> epsilon_z, bool preserve_topology,
+                      bool return_stats, std::optional<double> timeout,
+                      const py::object &cancel, const std::string &on_timeout,
+                      bool approximate)
 {
-    RowVectors ret(mask.sum(), coords.cols());
-    int N = mask.size();
-    for (int i = 0, k = 0; i < N; ++i) {
-        if (mask[i]) {
-            ret.row(k++) = coords.row(i);
+    using Scalar = typename Coords::Scalar;
+    if constexpr (std::is_integral<Scalar>::value) {
+        if (!integer_engine<Scalar>(coords, approximate, metric, epsilon_xy,
+                                    epsilon_z, preserve_topology)) {
+            // float64 in & out
+            const RowVectorsNx2 xys = coords.template cast<double>();
+            return rdp_coords<RowVectorsNx2>(
+                xys, epsilon, recursive, metric, epsilon_xy, epsilon_z,
+                preserve_topology, return_stats, timeout, cancel, on_timeout,
+                approximate);
         }
     }
-    return ret;
+    RdpStats stats;
+    auto *s = return_stats ? &stats : nullptr;
+    auto budget = make_budget(timeout, token(cancel), on_timeout);
+    Coords ret;
+    {
+        // so that cancel can be set from another python thread
+        py::gil_scoped_release release;
+        ret = select_by_mask(
+            coords,
+            rdp_mask(coords, epsilon, recursive, approximate, metric,
+                     epsilon_xy, epsilon_z, preserve_topology, s,
+                     budget ? &*budget : nullptr));
+    }
+    if (s) {
+        s->allocated(ret.size() * sizeof(typename Coords::Scalar));
+    }
+    return with_stats(std::move(ret), s);
 }
 
-inline RowVectors douglas_simplify(const Eigen::Ref<const RowVectors> &coords,
-                                   double epsilon, bool recursive)
+// rdp & rdp_mask for Nx3, Nx2 or Nx4 coords, or Nx2 int32/int16 coords
+template <typename Coords>
+void def_rdp(py::module &m, const char *rdp_doc, const char *rdp_mask_doc)
 {
-    return select_by_mask(coords,
-                          douglas_simplify_mask(coords, epsilon, recursive));
+    // integer coords only from arrays of that dtype
+    const bool convert = !std::is_integral<typename Coords::Scalar>::value;
+    m.def("rdp", &rdp_coords<Coords>, rdp_doc,
+          py::arg("coords").noconvert(!convert), //
+          py::kw_only(), "epsilon"_a = 0.0, "recursive"_a = true,
+          "metric"_a = "segment", "epsilon_xy"_a = std::nullopt,
+          "epsilon_z"_a = std::nullopt, "preserve_topology"_a = false,
+          "return_stats"_a = false, "timeout"_a = std::nullopt,
+          "cancel"_a = py::none(), "on_timeout"_a = "partial",
+          "approximate"_a = false);
+    m.def(
+        "rdp_mask",
+        [](const Eigen::Ref<const Coords> &coords, double epsilon,
+           bool recursive, const std::string &metric,
+           std::optional<double> epsilon_xy, std::optional<double> epsilon_z,
+           bool preserve_topology, bool return_stats,
+           std::optional<double> timeout, const py::object &cancel,
+           const std::string &on_timeout, bool approximate) {
+            RdpStats stats;
+            auto *s = return_stats ? &stats : nullptr;
+            auto budget = make_budget(timeout, token(cancel), on_timeout);
+            Eigen::VectorXi mask;
+            {
+                py::gil_scoped_release release;
+                mask = rdp_mask(coords, epsilon, recursive, approximate, metric,
+                                epsilon_xy, epsilon_z, preserve_topology, s,
+                                budget ? &*budget : nullptr);
+            }
+            return with_stats(std::move(mask), s);
+        },
+        rdp_mask_doc, py::arg("coords").noconvert(!convert), //
+        py::kw_only(), "epsilon"_a = 0.0, "recursive"_a = true,
+        "metric"_a = "segment", "epsilon_xy"_a = std::nullopt,
+        "epsilon_z"_a = std::nullopt, "preserve_topology"_a = false,
+        "return_stats"_a = false, "timeout"_a = std::nullopt,
+        "cancel"_a = py::none(), "on_timeout"_a = "partial",
+        "approximate"_a = false);
 }
 
-namespace py = pybind11;
-using namespace pybind11::literals;
-
 PYBIND11_MODULE(_fast_rdp, m)
 {
     m.doc() = R"pbdoc(
@@ -202,58 +364,122 @@ PYBIND11_MODULE(_fast_rdp, m)
         //
         ;
 
+    py::class_<RdpStats>(m, "RdpStats", R"pbdoc(
+        Counters of one rdp call (rdp(..., return_stats=True)).
+    )pbdoc")
+        .def_readonly("distance_evaluations", &RdpStats::distance_evaluations)
+        .def_readonly("subproblems", &RdpStats::subproblems,
+                      "spans scanned for their farthest point")
+        .def_readonly("max_depth", &RdpStats::max_depth,
+                      "recursion depth (recursive=True), else 0")
+        .def_readonly("max_queue_size", &RdpStats::max_queue_size,
+                      "queue/stack high-water mark (recursive=False, "
+                      "approximate), else 0")
+        .def_readonly("kept", &RdpStats::kept)
+        .def_readonly("bytes_allocated", &RdpStats::bytes_allocated,
+                      "bytes allocated by the call (padded Nx2 input, mask, "
+                      "queue, output)")
+        .def_readonly("peak_bytes", &RdpStats::peak_bytes,
+                      "max bytes in use at once")
+        .def_readonly("cancelled", &RdpStats::cancelled,
+                      "timeout/cancel hit, the output is partial (coarser)")
+        .def("__repr__",
+             [](const RdpStats &s) {
+                 return "RdpStats(distance_evaluations=" +
+                        std::to_string(s.distance_evaluations) +
+                        ", subproblems=" + std::to_string(s.subproblems) +
+                        ", max_depth=" + std::to_string(s.max_depth) +
+                        ", max_queue_size=" +
+                        std::to_string(s.max_queue_size) +
+                        ", kept=" + std::to_string(s.kept) +
+                        ", bytes_allocated=" +
+                        std::to_string(s.bytes_allocated) +
+                        ", peak_bytes=" + std::to_string(s.peak_bytes) +
+                        ", cancelled=" + (s.cancelled ? "True" : "False") +
+                        ")";
+             })
+        //
+        ;
+
     auto rdp_doc = R"pbdoc(
         Simplifies a given array of points using the Ramer-Douglas-Peucker algorithm.
 
+        metric: distance from point to the candidate line
+            "segment" (default): to the segment, clamped at its ends
+            "line": to the infinite line (same as the python rdp package)
+            "horizontal": to the segment in xy-plane, z is ignored
+            "vertical": |dz| to the segment (for Nx2 input, |dy|)
+            "sed": synchronized euclidean distance of a trajectory, rows are
+                (x, y, t) or (x, y, z, t): distance to the position on the
+                segment interpolated at the point's time (TD-TR). timestamps
+                should be non-decreasing, Nx4 input only works with "sed".
+        epsilon_xy, epsilon_z: separate horizontal/vertical tolerances, a point
+            is kept if it exceeds either of them (unset one is not checked).
+            overrides epsilon, only works with "segment" metric.
+        preserve_topology: refine the output until it does not self-intersect
+            (in xy-plane), works for polylines and rings (first == last).
+        return_stats: return (result, RdpStats) instead, with the counters of
+            the simplification (distance evaluations, subproblems, depth) and
+            its memory (bytes allocated, peak bytes).
+        timeout (seconds), cancel (CancellationToken): the simplification is
+            stopped once the timeout expires or cancel.cancel() is called
+            (checked at every subproblem and every 4096 scanned points).
+        on_timeout: "partial" (default) returns the coarser, still valid
+            simplification found so far (stats.cancelled is set), "raise"
+            raises Cancelled (a TimeoutError).
+        int32/int16 Nx2 coords (tiles, quantized data) use an exact integer
+            engine: distances in int64 (128-bit products), compared exactly
+            to epsilon^2, no floats in the scan, the output keeps the dtype.
+            same points as float64 input (up to its rounding of near ties).
+            only with "segment" metric, no epsilon_xy/epsilon_z,
+            preserve_topology or approximate, and |coords| < 2^30; else the
+            coords are simplified (and returned) as float64.
+        approximate: bounded-error mode, faster on long inputs: spans are split
+            at the farthest of 64 sampled points, only spans within epsilon at
+            the samples are fully scanned. every dropped point is still within
+            epsilon of the output, but it is not the exact rdp output (usually
+            a few more points). recursive is ignored.
+
         Example:
         >>> from fast_rdp import rdp
         >>> rdp([[1, 1], [2, 2], [3, 3], [4, 4]])
         [[1, 1], [4, 4]]
     )pbdoc";
 
-    m.def(
-        "rdp",
-        [](const Eigen::Ref<const RowVectors> &coords, double epsilon,
-           bool recursive) -> RowVectors {
-            return douglas_simplify(coords, epsilon, recursive);
-        },
-        rdp_doc, "coords"_a, //
-        py::kw_only(), "epsilon"_a = 0.0, "recursive"_a = true);
-    m.def(
-        "rdp",
-        [](const Eigen::Ref<const RowVectorsNx2> &coords, double epsilon,
-           bool recursive) -> RowVectorsNx2 {
-            RowVectors xyzs(coords.rows(), 3);
-            xyzs.setZero();
-            xyzs.leftCols(2) = coords;
-            return douglas_simplify(xyzs, epsilon, recursive).leftCols(2);
-        },
-        rdp_doc, "coords"_a, //
-        py::kw_only(), "epsilon"_a = 0.0, "recursive"_a = true);
+    py::class_<CancellationToken>(m, "CancellationToken", R"pbdoc(
+        Cancels running rdp calls it is passed to (cancel=), from any thread.
+    )pbdoc")
+        .def(py::init<>())
+        .def("cancel", &CancellationToken::cancel)
+        .def_property_readonly("cancelled", &CancellationToken::cancelled)
+        //
+        ;
+    py::register_exception<Cancelled>(m, "Cancelled", PyExc_TimeoutError);
 
     auto rdp_mask_doc = R"pbdoc(
         Simplifies a given array of points using the Ramer-Douglas-Peucker algorithm.
         return a mask.
     )pbdoc";
-    m.def(
-        "rdp_mask",
-        [](const Eigen::Ref<const RowVectors> &coords, double epsilon,
-           bool recursive) -> Eigen::VectorXi {
-            return douglas_simplify_mask(coords, epsilon, recursive);
-        },
-        rdp_mask_doc, "coords"_a, //
-        py::kw_only(), "epsilon"_a = 0.0, "recursive"_a = true);
-    m.def(
-        "rdp_mask",
-        [](const Eigen::Ref<const RowVectorsNx2> &coords, double epsilon,
-           bool recursive) -> Eigen::VectorXi {
-            RowVectors xyzs(coords.rows(), 3);
-            xyzs.setZero();
-            xyzs.leftCols(2) = coords;
-            return douglas_simplify_mask(xyzs, epsilon, recursive);
-        },
-        rdp_mask_doc, "coords"_a, //
-        py::kw_only(), "epsilon"_a = 0.0, "recursive"_a = true);
+
+    // only int32/int16 arrays go to the integer engine, as they are (no
+    // conversion), other ints (e.g. int64) still go to float64
+    def_rdp<IntRowVectorsNx2<int32_t>>(m, rdp_doc, rdp_mask_doc);
+    def_rdp<IntRowVectorsNx2<int16_t>>(m, rdp_doc, rdp_mask_doc);
+    def_rdp<RowVectors>(m, rdp_doc, rdp_mask_doc);
+    def_rdp<RowVectorsNx2>(m, rdp_doc, rdp_mask_doc);
+    def_rdp<RowVectorsNx4>(m, rdp_doc, rdp_mask_doc);
+
+    bind_network(m);
+    bind_geojson(m);
+    bind_geojsonvt(m);
+    bind_flatgeobuf(m);
+    bind_codec(m);
+    bind_multires(m);
+    bind_trace(m);
+    bind_simplification_error(m);
+    bind_sleeve(m);
+    bind_squish(m);
+    bind_dead_reckoning(m);
 
 #ifdef VERSION_INFO
     m.attr("__version__") = MACRO_STRINGIFY(VERSION_INFO);
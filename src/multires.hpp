@@ -0,0 +1,228 @@
+#ifndef FAST_RDP_MULTIRES_HPP
+#define FAST_RDP_MULTIRES_HPP
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+#include "trace.hpp"
+
+#include <cista/mmap.h>
+#include <cista/serialization.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fast_rdp
+{
+namespace multires
+{
+namespace data = cista::offset;
+
+// cista (offset) layout of a multi-resolution index: lines are concatenated,
+// line i is [offsets[i], offsets[i + 1]) of xyzs (Nx3, row major) and
+// importance (see douglas_importance, endpoints are +inf)
+struct Data
+{
+    uint32_t dims;   // 2 or 3, of the input
+    uint32_t metric; // DistanceMetric
+    double min_epsilon;
+    data::vector<uint64_t> offsets;
+    data::vector<double> xyzs;
+    data::vector<double> importance;
+};
+
+// checksum of the whole file, verified when it is opened
+constexpr auto MODE =
+    cista::mode::WITH_VERSION | cista::mode::WITH_INTEGRITY;
+} // namespace multires
+
+// Builds a multi-resolution index of lines (Nx3, dims: 2 if z is padding):
+// per-vertex rdp importance is computed once per line (in parallel), so that
+// rdp at any epsilon >= min_epsilon is a threshold scan (importance >
+// epsilon^2). Coordinates, importance and line offsets are written to path
+// with cista, to be memory-mapped by MultiResolutionIndex.
+inline void
+build_multires_index(const std::string &path,
+                     const std::vector<RowVectors> &lines, int dims,
+                     double min_epsilon = 0.0,
+                     DistanceMetric metric = DistanceMetric::Segment,
+                     int num_threads = 0)
+{
+    if (min_epsilon < 0) {
+        throw std::invalid_argument("min_epsilon should be >= 0");
+    }
+    const int L = lines.size();
+    multires::Data index;
+    index.dims = dims;
+    index.metric = static_cast<uint32_t>(metric);
+    index.min_epsilon = min_epsilon;
+    index.offsets.resize(L + 1);
+    index.offsets[0] = 0;
+    for (int i = 0; i < L; ++i) {
+        index.offsets[i + 1] = index.offsets[i] + lines[i].rows();
+    }
+    index.xyzs.resize(index.offsets[L] * 3);
+    index.importance.resize(index.offsets[L]);
+    parallel_for(
+        L,
+        [&](int i) {
+            const int N = lines[i].rows();
+            trace::Scope scope("importance", "multires", i, N);
+            if (N == 0) {
+                return;
+            }
+            const uint64_t offset = index.offsets[i];
+            Eigen::Map<RowVectors>(&index.xyzs[offset * 3], N, 3) = lines[i];
+            Eigen::Map<Eigen::VectorXd> importance(&index.importance[offset],
+                                                   N);
+            importance.setZero();
+            importance[0] = importance[N - 1] =
+                std::numeric_limits<double>::infinity();
+            dispatch_metric(metric, [&](const auto &policy) {
+                douglas_importance(lines[i], importance, 0, N - 1,
+                                   min_epsilon * min_epsilon, policy, true);
+            });
+        },
+        num_threads);
+    cista::buf<cista::mmap> mmap{cista::mmap{path.c_str()}};
+    cista::serialize<multires::MODE>(mmap, index);
+}
+
+// A memory-mapped multi-resolution index (build_multires_index), read in
+// place: no deserialization, lines at any epsilon are extracted by a
+// threshold scan over the mapped importance.
+class MultiResolutionIndex
+{
+  public:
+    explicit MultiResolutionIndex(const std::string &path)
+        : mmap_(path.c_str(), cista::mmap::protection::READ)
+    {
+        if (mmap_.size() == 0) {
+            throw std::runtime_error("empty multi-resolution index: " + path);
+        }
+        try {
+            index_ = cista::deserialize<multires::Data, multires::MODE>(
+                mmap_.data(), mmap_.data() + mmap_.size());
+        } catch (const std::exception &e) {
+            throw std::runtime_error("invalid multi-resolution index: " + path +
+                                     " (" + e.what() + ")");
+        }
+        if (const char *error = validate(*index_)) {
+            throw std::runtime_error("invalid multi-resolution index: " + path +
+                                     " (" + error + ")");
+        }
+    }
+
+    int size() const { return index_->offsets.size() - 1; }
+    int dims() const { return index_->dims; }
+    double min_epsilon() const { return index_->min_epsilon; }
+    DistanceMetric metric() const
+    {
+        return static_cast<DistanceMetric>(index_->metric);
+    }
+
+    // zero-copy views of line i
+    Eigen::Map<const RowVectors> coords(int i) const
+    {
+        check(i);
+        return {index_->xyzs.data() + 3 * begin(i), num_points(i), 3};
+    }
+    Eigen::Map<const Eigen::VectorXd> importance(int i) const
+    {
+        check(i);
+        return {index_->importance.data() + begin(i), num_points(i)};
+    }
+
+    // same as douglas_simplify_mask(coords(i), epsilon, metric())
+    Eigen::VectorXi mask(int i, double epsilon) const
+    {
+        auto importance = this->importance(i);
+        const double threshold = this->threshold(epsilon);
+        return (importance.array() > threshold).cast<int>();
+    }
+    RowVectors simplify(int i, double epsilon) const
+    {
+        auto coords = this->coords(i);
+        auto importance = this->importance(i);
+        const double threshold = this->threshold(epsilon);
+        const int N = importance.size();
+        RowVectors ret((importance.array() > threshold).count(), 3);
+        for (int k = 0, n = 0; k < N; ++k) {
+            if (importance[k] > threshold) {
+                ret.row(n++) = coords.row(k);
+            }
+        }
+        return ret;
+    }
+    std::vector<RowVectors> simplify(double epsilon, int num_threads = 0) const
+    {
+        std::vector<RowVectors> ret(size());
+        threshold(epsilon);
+        parallel_for(
+            ret.size(), [&](int i) { ret[i] = simplify(i, epsilon); },
+            num_threads);
+        return ret;
+    }
+
+  private:
+    cista::mmap mmap_;
+    const multires::Data *index_ = nullptr;
+
+    // what is inconsistent in index (nullptr if nothing): lines are read
+    // through offsets without further checks
+    static const char *validate(const multires::Data &index)
+    {
+        const auto &offsets = index.offsets;
+        if (offsets.empty() || offsets[0] != 0) {
+            return "offsets should start at 0";
+        }
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            if (offsets[i] < offsets[i - 1]) {
+                return "offsets should be non-decreasing";
+            }
+        }
+        if (offsets.back() != index.importance.size() ||
+            3 * index.importance.size() != index.xyzs.size()) {
+            return "offsets, coordinates & importance sizes differ";
+        }
+        if (offsets.size() - 1 >
+            static_cast<size_t>(std::numeric_limits<int>::max())) {
+            return "too many lines";
+        }
+        if (index.dims != 2 && index.dims != 3) {
+            return "dims should be 2 or 3";
+        }
+        if (index.metric > static_cast<uint32_t>(DistanceMetric::Sed)) {
+            return "unknown metric";
+        }
+        return nullptr;
+    }
+
+    uint64_t begin(int i) const { return index_->offsets[i]; }
+    int num_points(int i) const
+    {
+        return index_->offsets[i + 1] - index_->offsets[i];
+    }
+    void check(int i) const
+    {
+        if (i < 0 || i >= size()) {
+            throw std::out_of_range("line index out of range: " +
+                                    std::to_string(i));
+        }
+    }
+    double threshold(double epsilon) const
+    {
+        if (!(epsilon >= index_->min_epsilon)) {
+            throw std::invalid_argument(
+                "epsilon should be >= min_epsilon of the index (" +
+                std::to_string(index_->min_epsilon) + ")");
+        }
+        return epsilon * epsilon;
+    }
+};
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,399 @@
+#ifndef FAST_RDP_MVT_HPP
+#define FAST_RDP_MVT_HPP
+
+#include "parallel.hpp"
+
+#include <mapbox/feature.hpp>
+#include <protozero/buffer_string.hpp>
+#include <protozero/pbf_writer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fast_rdp
+{
+// Mapbox Vector Tile (v2.1) encoding, see
+// https://github.com/mapbox/vector-tile-spec/blob/master/2.1/vector_tile.proto
+namespace mvt
+{
+enum GeomType : int32_t
+{
+    UNKNOWN = 0,
+    POINT = 1,
+    LINESTRING = 2,
+    POLYGON = 3,
+};
+
+// field numbers
+enum : protozero::pbf_tag_type
+{
+    TILE_LAYERS = 3,
+    LAYER_NAME = 1,
+    LAYER_FEATURES = 2,
+    LAYER_KEYS = 3,
+    LAYER_VALUES = 4,
+    LAYER_EXTENT = 5,
+    LAYER_VERSION = 15,
+    FEATURE_ID = 1,
+    FEATURE_TAGS = 2,
+    FEATURE_TYPE = 3,
+    FEATURE_GEOMETRY = 4,
+    VALUE_STRING = 1,
+    VALUE_DOUBLE = 3,
+    VALUE_UINT = 5,
+    VALUE_SINT = 6,
+    VALUE_BOOL = 7,
+};
+
+// command integers & zigzag parameters, relative to the cursor
+class GeometryEncoder
+{
+  public:
+    std::vector<uint32_t> commands;
+
+    // n points, xy(i) -> (x, y)
+    template <typename XY> bool points(int n, XY &&xy)
+    {
+        if (n == 0) {
+            return false;
+        }
+        command(1, n); // MoveTo
+        for (int i = 0; i < n; ++i) {
+            auto p = xy(i);
+            param(p.first, p.second);
+        }
+        return true;
+    }
+
+    // linestring (closed = ring, without its repeated last point). repeated
+    // points are dropped, lines < 2 points & rings < 3 points are skipped.
+    // sign: for rings, 1 to write them with positive area (exterior), -1 for
+    // negative (interior), reversed if needed
+    template <typename XY> bool line(int n, XY &&xy, bool closed, int sign = 0)
+    {
+        path_.clear();
+        for (int i = 0; i < n; ++i) {
+            auto p = xy(i);
+            if (path_.empty() || p != path_.back()) {
+                path_.push_back(p);
+            }
+        }
+        if (closed && path_.size() > 1 && path_.front() == path_.back()) {
+            path_.pop_back();
+        }
+        const int m = path_.size();
+        if (m < (closed ? 3 : 2)) {
+            return false;
+        }
+        if (closed) {
+            // surveyor's formula, tile coordinates (y down)
+            int64_t area2 = 0;
+            for (int i = 0, j = m - 1; i < m; j = i++) {
+                area2 += path_[j].first * path_[i].second -
+                         path_[i].first * path_[j].second;
+            }
+            if (area2 == 0) {
+                return false;
+            }
+            if ((area2 > 0) != (sign > 0)) {
+                std::reverse(path_.begin(), path_.end());
+            }
+        }
+        command(1, 1);
+        param(path_[0].first, path_[0].second);
+        command(2, m - 1); // LineTo
+        for (int i = 1; i < m; ++i) {
+            param(path_[i].first, path_[i].second);
+        }
+        if (closed) {
+            command(7, 1); // ClosePath
+        }
+        return true;
+    }
+
+  private:
+    int64_t x_ = 0, y_ = 0;
+    std::vector<std::pair<int64_t, int64_t>> path_;
+
+    void command(uint32_t id, uint32_t count)
+    {
+        commands.push_back((id & 0x7) | (count << 3));
+    }
+    void param(int64_t x, int64_t y)
+    {
+        commands.push_back(protozero::encode_zigzag32(x - x_));
+        commands.push_back(protozero::encode_zigzag32(y - y_));
+        x_ = x;
+        y_ = y;
+    }
+};
+
+// mapbox geometry -> GeometryEncoder, returns the MVT geometry type (UNKNOWN
+// for empty geometries & geometry collections)
+template <typename T> struct EncodeGeometry
+{
+    GeometryEncoder &encoder;
+
+    template <typename Points> static auto xy(const Points &points)
+    {
+        return [&points](int i) {
+            return std::make_pair<int64_t, int64_t>(points[i].x, points[i].y);
+        };
+    }
+    template <typename Polygon> bool polygon(const Polygon &polygon) const
+    {
+        bool written = false;
+        for (int i = 0, N = polygon.size(); i < N; ++i) {
+            const auto &ring = polygon[i];
+            // interior rings of a skipped exterior ring are skipped too
+            if (i > 0 && !written) {
+                break;
+            }
+            bool ok = encoder.line(ring.size(), xy(ring), true, i ? -1 : 1);
+            written = written || ok;
+        }
+        return written;
+    }
+
+    GeomType operator()(const mapbox::geometry::empty &) const
+    {
+        return UNKNOWN;
+    }
+    GeomType operator()(const mapbox::geometry::point<T> &p) const
+    {
+        encoder.points(1, [&](int) {
+            return std::make_pair<int64_t, int64_t>(p.x, p.y);
+        });
+        return POINT;
+    }
+    GeomType operator()(const mapbox::geometry::multi_point<T> &mp) const
+    {
+        return encoder.points(mp.size(), xy(mp)) ? POINT : UNKNOWN;
+    }
+    GeomType operator()(const mapbox::geometry::line_string<T> &ls) const
+    {
+        return encoder.line(ls.size(), xy(ls), false) ? LINESTRING : UNKNOWN;
+    }
+    GeomType
+    operator()(const mapbox::geometry::multi_line_string<T> &mls) const
+    {
+        bool written = false;
+        for (const auto &ls : mls) {
+            bool ok = encoder.line(ls.size(), xy(ls), false);
+            written = written || ok;
+        }
+        return written ? LINESTRING : UNKNOWN;
+    }
+    GeomType operator()(const mapbox::geometry::polygon<T> &p) const
+    {
+        return polygon(p) ? POLYGON : UNKNOWN;
+    }
+    GeomType operator()(const mapbox::geometry::multi_polygon<T> &mp) const
+    {
+        bool written = false;
+        for (const auto &p : mp) {
+            bool ok = polygon(p);
+            written = written || ok;
+        }
+        return written ? POLYGON : UNKNOWN;
+    }
+    GeomType
+    operator()(const mapbox::geometry::geometry_collection<T> &) const
+    {
+        return UNKNOWN; // not in MVT, see LayerEncoder::add_feature
+    }
+};
+
+// one layer: features, deduplicated keys & values
+class LayerEncoder
+{
+  public:
+    LayerEncoder(std::string name, uint32_t extent)
+        : name_(std::move(name)), extent_(extent)
+    {
+    }
+
+    // geometry collections are written as one feature per geometry. null,
+    // array & object property values are skipped (no MVT value types)
+    template <typename T>
+    void add_feature(const mapbox::geometry::geometry<T> &geometry,
+                     const mapbox::feature::property_map &properties,
+                     const mapbox::feature::identifier &id)
+    {
+        if (geometry.template is<mapbox::geometry::geometry_collection<T>>()) {
+            for (const auto &g : geometry.template get<
+                                 mapbox::geometry::geometry_collection<T>>()) {
+                add_feature(g, properties, id);
+            }
+            return;
+        }
+        GeometryEncoder encoder;
+        GeomType type = mapbox::geometry::geometry<T>::visit(
+            geometry, EncodeGeometry<T>{encoder});
+        if (type == UNKNOWN) {
+            return;
+        }
+        add_feature(type, encoder.commands, properties, id);
+    }
+    void add_feature(GeomType type, const std::vector<uint32_t> &commands,
+                     const mapbox::feature::property_map &properties = {},
+                     const mapbox::feature::identifier &id = {})
+    {
+        protozero::pbf_writer layer(layer_features_);
+        protozero::pbf_writer feature(layer, LAYER_FEATURES);
+        id.match([&](uint64_t v) { feature.add_uint64(FEATURE_ID, v); },
+                 [&](int64_t v) {
+                     if (v >= 0) {
+                         feature.add_uint64(FEATURE_ID, v);
+                     }
+                 },
+                 [&](double v) {
+                     if (v >= 0 && v == std::floor(v) && v < 1.8e19) {
+                         feature.add_uint64(FEATURE_ID, v);
+                     }
+                 },
+                 [](const auto &) {});
+        tags_.clear();
+        for (const auto &pair : properties) {
+            if (!encode_value(pair.second)) {
+                continue;
+            }
+            tags_.push_back(index(keys_, key_index_, pair.first));
+            tags_.push_back(index(values_, value_index_, value_));
+        }
+        if (!tags_.empty()) {
+            feature.add_packed_uint32(FEATURE_TAGS, tags_.begin(), tags_.end());
+        }
+        feature.add_enum(FEATURE_TYPE, type);
+        feature.add_packed_uint32(FEATURE_GEOMETRY, commands.begin(),
+                                  commands.end());
+    }
+
+    std::string encode() const
+    {
+        std::string layer;
+        {
+            protozero::pbf_writer writer(layer);
+            writer.add_uint32(LAYER_VERSION, 2);
+            writer.add_string(LAYER_NAME, name_);
+        }
+        layer += layer_features_;
+        {
+            protozero::pbf_writer writer(layer);
+            for (const auto &key : keys_) {
+                writer.add_string(LAYER_KEYS, key);
+            }
+            for (const auto &value : values_) {
+                writer.add_message(LAYER_VALUES, value);
+            }
+            writer.add_uint32(LAYER_EXTENT, extent_);
+        }
+        return layer;
+    }
+
+  private:
+    std::string name_;
+    uint32_t extent_;
+    std::string layer_features_; // Layer.features fields
+    std::vector<uint32_t> tags_;
+    std::string value_; // scratch Value message
+    std::vector<std::string> keys_, values_;
+    std::unordered_map<std::string, uint32_t> key_index_, value_index_;
+
+    static uint32_t index(std::vector<std::string> &items,
+                          std::unordered_map<std::string, uint32_t> &indexes,
+                          const std::string &item)
+    {
+        auto it = indexes.emplace(item, items.size());
+        if (it.second) {
+            items.push_back(item);
+        }
+        return it.first->second;
+    }
+
+    bool encode_value(const mapbox::feature::value &value)
+    {
+        value_.clear();
+        protozero::pbf_writer writer(value_);
+        return value.match(
+            [&](const std::string &v) {
+                writer.add_string(VALUE_STRING, v);
+                return true;
+            },
+            [&](bool v) {
+                writer.add_bool(VALUE_BOOL, v);
+                return true;
+            },
+            [&](uint64_t v) {
+                writer.add_uint64(VALUE_UINT, v);
+                return true;
+            },
+            [&](int64_t v) {
+                writer.add_sint64(VALUE_SINT, v);
+                return true;
+            },
+            [&](double v) {
+                writer.add_double(VALUE_DOUBLE, v);
+                return true;
+            },
+            [](const auto &) { return false; });
+    }
+};
+
+// a tile of one layer
+inline std::string encode_tile(const LayerEncoder &layer)
+{
+    std::string tile;
+    protozero::pbf_writer writer(tile);
+    writer.add_message(TILE_LAYERS, layer.encode());
+    return tile;
+}
+} // namespace mvt
+
+// MVT tile of one layer from tile-space features (e.g. geojson-vt tiles)
+template <typename T>
+std::string encode_mvt(const mapbox::feature::feature_collection<T> &features,
+                       const std::string &layer, uint32_t extent = 4096)
+{
+    mvt::LayerEncoder encoder(layer, extent);
+    for (const auto &f : features) {
+        encoder.add_feature(f.geometry, f.properties, f.id);
+    }
+    return mvt::encode_tile(encoder);
+}
+
+// MVT tiles of linestrings (Nx2 tile coordinates, rounded), in parallel
+template <typename Coords>
+std::vector<std::string>
+encode_mvt_lines(const std::vector<std::vector<Coords>> &tiles,
+                 const std::string &layer, uint32_t extent = 4096,
+                 int num_threads = 0)
+{
+    std::vector<std::string> ret(tiles.size());
+    parallel_for(
+        tiles.size(),
+        [&](int i) {
+            mvt::LayerEncoder encoder(layer, extent);
+            for (const auto &line : tiles[i]) {
+                mvt::GeometryEncoder geometry;
+                auto xy = [&line](int k) {
+                    return std::make_pair<int64_t, int64_t>(
+                        std::llround(line(k, 0)), std::llround(line(k, 1)));
+                };
+                if (geometry.line(line.rows(), xy, false)) {
+                    encoder.add_feature(mvt::LINESTRING, geometry.commands);
+                }
+            }
+            ret[i] = mvt::encode_tile(encoder);
+        },
+        num_threads);
+    return ret;
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef FAST_RDP_NETWORK_HPP
+#define FAST_RDP_NETWORK_HPP
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+#include "topology.hpp"
+#include "trace.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace fast_rdp
+{
+using CoordKey = std::array<double, 3>;
+
+// exact coordinates, -0.0 and 0.0 are the same vertex
+inline CoordKey coord_key(const Eigen::Ref<const RowVectors> &coords, int i)
+{
+    return {coords(i, 0) + 0.0, coords(i, 1) + 0.0, coords(i, 2) + 0.0};
+}
+
+struct CoordKeyHash
+{
+    size_t operator()(const CoordKey &key) const
+    {
+        uint64_t bits[3];
+        std::memcpy(bits, key.data(), sizeof(bits));
+        return phmap::HashState().combine(0, bits[0], bits[1], bits[2]);
+    }
+};
+
+// Marks vertices whose coordinates appear in more than one line (junctions,
+// shared endpoints). The coordinate -> owner index is a sharded parallel hash
+// map, so lines are hashed concurrently.
+inline std::vector<Eigen::VectorXi>
+shared_vertices(const std::vector<RowVectors> &lines, int num_threads = 0)
+{
+    // value: index of the first line with this coordinate, -1 if shared
+    using Owners = phmap::parallel_flat_hash_map<
+        CoordKey, int, CoordKeyHash, std::equal_to<CoordKey>,
+        std::allocator<std::pair<const CoordKey, int>>, 4, std::mutex>;
+    Owners owners;
+    const int num_lines = lines.size();
+    parallel_for(
+        num_lines,
+        [&](int l) {
+            const auto &line = lines[l];
+            for (int i = 0, N = line.rows(); i < N; ++i) {
+                owners.try_emplace_l(
+                    coord_key(line, i),
+                    [l](Owners::value_type &v) {
+                        if (v.second != l) {
+                            v.second = -1;
+                        }
+                    },
+                    l);
+            }
+        },
+        num_threads);
+    std::vector<Eigen::VectorXi> shared(num_lines);
+    parallel_for(
+        num_lines,
+        [&](int l) {
+            const auto &line = lines[l];
+            auto &mask = shared[l];
+            mask.setZero(line.rows());
+            for (int i = 0, N = line.rows(); i < N; ++i) {
+                owners.if_contains(coord_key(line, i),
+                                   [&](const Owners::value_type &v) {
+                                       mask[i] = v.second < 0;
+                                   });
+            }
+        },
+        num_threads);
+    return shared;
+}
+
+// Simplifies lines independently, in parallel. Vertices already set in masks
+// (if given, e.g. shared vertices) are kept and split the recursion.
+template <typename Metric = SegmentMetric>
+void douglas_simplify_batch(const std::vector<RowVectors> &lines,
+                            std::vector<Eigen::VectorXi> &masks,
+                            double epsilon, bool recursive,
+                            const Metric &metric = {}, int num_threads = 0)
+{
+    masks.resize(lines.size());
+    parallel_for(
+        lines.size(),
+        [&](int l) {
+            trace::Scope scope(recursive ? "recursive" : "iterative",
+                               "rdp_batch", l, lines[l].rows());
+            auto &mask = masks[l];
+            if (mask.size() != lines[l].rows()) {
+                mask.setZero(lines[l].rows());
+            }
+            douglas_simplify_anchored(lines[l], mask, epsilon, recursive,
+                                      metric);
+        },
+        num_threads);
+}
+
+// Simplifies a network of polylines, vertices shared by several lines are
+// always kept (and split the recursion), so the simplified lines stay
+// connected. Lines are simplified in parallel.
+template <typename Metric = SegmentMetric>
+std::vector<Eigen::VectorXi>
+douglas_simplify_network_masks(const std::vector<RowVectors> &lines,
+                               double epsilon, bool recursive,
+                               const Metric &metric = {}, int num_threads = 0)
+{
+    auto masks = shared_vertices(lines, num_threads);
+    douglas_simplify_batch(lines, masks, epsilon, recursive, metric,
+                           num_threads);
+    return masks;
+}
+
+inline std::vector<Eigen::VectorXi>
+douglas_simplify_network_masks(const std::vector<RowVectors> &lines,
+                               double epsilon, bool recursive,
+                               DistanceMetric metric, int num_threads = 0)
+{
+    return dispatch_metric(metric, [&](const auto &policy) {
+        return douglas_simplify_network_masks(lines, epsilon, recursive,
+                                              policy, num_threads);
+    });
+}
+// batch simplification with optional shared vertices & topology constraints
+inline std::vector<Eigen::VectorXi>
+douglas_simplify_batch_masks(const std::vector<RowVectors> &lines,
+                             double epsilon, bool recursive,
+                             DistanceMetric metric, bool keep_shared_vertices,
+                             bool preserve_topology, int num_threads = 0)
+{
+    return dispatch_metric(metric, [&](const auto &policy) {
+        std::vector<Eigen::VectorXi> masks;
+        if (keep_shared_vertices) {
+            masks = shared_vertices(lines, num_threads);
+        }
+        douglas_simplify_batch(lines, masks, epsilon, recursive, policy,
+                               num_threads);
+        if (preserve_topology) {
+            std::vector<Eigen::Ref<const RowVectors>> refs(lines.begin(),
+                                                           lines.end());
+            fast_rdp::preserve_topology(refs, masks, true, policy);
+        }
+        return masks;
+    });
+}
+} // namespace fast_rdp
+
+#endif
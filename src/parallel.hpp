@@ -0,0 +1,70 @@
+#ifndef FAST_RDP_PARALLEL_HPP
+#define FAST_RDP_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fast_rdp
+{
+inline int resolve_num_threads(int num_threads, int num_tasks)
+{
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::max(1, std::min(num_threads, num_tasks));
+}
+
+// calls fn(i) for i in [0, n) on up to num_threads threads (<= 0: one per
+// core). tasks are handed out one by one from an atomic counter, so lines of
+// very different sizes still balance out. the first exception thrown by fn is
+// rethrown in the calling thread (remaining tasks are skipped).
+template <typename Fn>
+void parallel_for(int n, Fn &&fn, int num_threads = 0)
+{
+    num_threads = resolve_num_threads(num_threads, n);
+    if (num_threads == 1) {
+        for (int i = 0; i < n; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<int> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        while (true) {
+            int i = next++;
+            if (i >= n) {
+                return;
+            }
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = n;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (int t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef FAST_RDP_PYBIND11_CODEC_HPP
+#define FAST_RDP_PYBIND11_CODEC_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "codec.hpp"
+
+#include <optional>
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+// encode_polyline for Nx3 or Nx2 coords
+template <typename Coords> void def_encode(py::module &m)
+{
+    m.def(
+        "encode_polyline",
+        [](const Eigen::Ref<const Coords> &coords,
+           const std::optional<Eigen::VectorXi> &mask, double resolution,
+           bool compress) {
+            std::string bytes;
+            {
+                py::gil_scoped_release release;
+                bytes = encode_polyline(coords, mask ? &*mask : nullptr,
+                                        resolution, compress);
+            }
+            return py::bytes(bytes);
+        },
+        R"pbdoc(
+        Encodes a polyline compactly: coordinates are quantized to multiples
+        of resolution, delta & zigzag varint encoded (gzipped if compress,
+        RuntimeError if built without zlib, see has_zlib).
+
+        mask: only rows where mask is set are encoded (e.g. rdp_mask output),
+            no simplified copy of coords is made.
+    )pbdoc",
+        "coords"_a, py::kw_only(), "mask"_a = std::nullopt,
+        "resolution"_a = 1e-6, "compress"_a = false);
+}
+
+using CoordsArray =
+    py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// encode_polylines of arrays, mapped in place
+template <typename Coords>
+std::string encode_arrays(const std::vector<CoordsArray> &arrays,
+                          const std::vector<Eigen::VectorXi> *masks,
+                          double resolution, bool compress, int num_threads)
+{
+    std::vector<Eigen::Map<const Coords>> lines;
+    lines.reserve(arrays.size());
+    for (const auto &array : arrays) {
+        lines.emplace_back(array.data(), array.shape(0), array.shape(1));
+    }
+    py::gil_scoped_release release;
+    return encode_polylines(lines, masks, resolution, compress, num_threads);
+}
+
+// lines (Nx3 or Nx2, all the same): float64 C-contiguous arrays are read in
+// place, others converted
+inline py::bytes
+encode_lines(const py::sequence &lines,
+             const std::optional<std::vector<Eigen::VectorXi>> &masks,
+             double resolution, bool compress, int num_threads)
+{
+    std::vector<CoordsArray> arrays;
+    arrays.reserve(lines.size());
+    int dims = 3; // of no lines
+    for (auto line : lines) {
+        auto array = CoordsArray::ensure(line);
+        if (!array || array.ndim() != 2 ||
+            (array.shape(1) != 2 && array.shape(1) != 3) ||
+            (!arrays.empty() && array.shape(1) != dims)) {
+            throw py::value_error(
+                "lines should be Nx3 or Nx2 arrays (all the same)");
+        }
+        dims = array.shape(1);
+        arrays.push_back(std::move(array));
+    }
+    const auto *m = masks ? &*masks : nullptr;
+    return py::bytes(
+        dims == 3 ? encode_arrays<RowVectors>(arrays, m, resolution, compress,
+                                              num_threads)
+                  : encode_arrays<RowVectorsNx2>(arrays, m, resolution,
+                                                 compress, num_threads));
+}
+
+inline void bind_codec(py::module &m)
+{
+    def_encode<RowVectors>(m);
+    def_encode<RowVectorsNx2>(m);
+    m.def("encode_polylines", &encode_lines, R"pbdoc(
+        Encodes polylines (Nx3 or Nx2, all the same) in parallel, see
+        encode_polyline. float64 C-contiguous arrays are read in place.
+
+        masks: e.g. rdp_batch_mask output.
+    )pbdoc",
+          "lines"_a, py::kw_only(), "masks"_a = std::nullopt,
+          "resolution"_a = 1e-6, "compress"_a = false, "num_threads"_a = 0);
+    // compress=True & gzipped input need zlib (optional at build time)
+    m.attr("has_zlib") = codec::has_zlib;
+    m.def(
+        "decode_polylines",
+        [](const py::bytes &data) {
+            std::string bytes = data;
+            int dims = 3;
+            std::vector<RowVectors> lines;
+            {
+                py::gil_scoped_release release;
+                lines = decode_polylines(bytes, &dims);
+            }
+            py::list ret;
+            for (auto &line : lines) {
+                if (dims == 3) {
+                    ret.append(py::cast(std::move(line)));
+                } else {
+                    ret.append(py::cast(RowVectorsNx2(line.leftCols(2))));
+                }
+            }
+            return ret;
+        },
+        R"pbdoc(
+        Decodes encode_polyline / encode_polylines output (gzipped or not)
+        into a list of Nx3 or Nx2 arrays.
+    )pbdoc",
+        "data"_a);
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef FAST_RDP_PYBIND11_DEAD_RECKONING_HPP
+#define FAST_RDP_PYBIND11_DEAD_RECKONING_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "dead_reckoning.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+// dead_reckoning & dead_reckoning_mask for lists of Nx3 or Nx4 tracks
+template <int Dims> void def_dead_reckoning(py::module &m, const char *doc)
+{
+    using Coords = typename DeadReckoning<Dims>::Coords;
+    m.def("dead_reckoning_mask", &dead_reckoning_masks<Dims>, doc,
+          "tracks"_a, py::kw_only(), "epsilon"_a = 0.0, "num_threads"_a = 0,
+          py::call_guard<py::gil_scoped_release>());
+    using Velocities =
+        Eigen::Matrix<double, Eigen::Dynamic, Dims - 1, Eigen::RowMajor>;
+    m.def(
+        "dead_reckoning",
+        [](const std::vector<Coords> &tracks, double epsilon, int num_threads,
+           bool return_velocities) -> py::object {
+            std::vector<Coords> ret;
+            std::vector<Velocities> velocities;
+            {
+                py::gil_scoped_release release;
+                auto masks = dead_reckoning_masks<Dims>(tracks, epsilon,
+                                                        num_threads);
+                ret.reserve(tracks.size());
+                for (int i = 0, N = tracks.size(); i < N; ++i) {
+                    ret.push_back(select_by_mask(tracks[i], masks[i]));
+                    if (return_velocities) {
+                        velocities.push_back(
+                            dead_reckoning_velocities<Dims>(tracks[i],
+                                                            masks[i]));
+                    }
+                }
+            }
+            if (return_velocities) {
+                return py::make_tuple(std::move(ret), std::move(velocities));
+            }
+            return py::cast(std::move(ret));
+        },
+        doc, "tracks"_a, py::kw_only(), "epsilon"_a = 0.0,
+        "num_threads"_a = 0, "return_velocities"_a = false);
+}
+
+inline void bind_dead_reckoning(py::module &m)
+{
+    py::class_<DeadReckoning<3>>(m, "DeadReckoning", R"pbdoc(
+        Dead reckoning of one track of (x, y, t) vertices, pushed one by one:
+        push returns True if the vertex is kept (see dead_reckoning), key and
+        velocity are what a receiver needs to predict the next positions.
+        finish() ends the track, keeps its last vertex: True if it was not
+        kept yet (key and velocity are then updated).
+    )pbdoc")
+        .def(py::init<double>(), py::kw_only(), "epsilon"_a)
+        .def("push", &DeadReckoning<3>::push, "P"_a)
+        .def("finish", &DeadReckoning<3>::finish)
+        .def_property_readonly("key", &DeadReckoning<3>::key,
+                               "last kept vertex")
+        .def_property_readonly(
+            "velocity",
+            py::overload_cast<>(&DeadReckoning<3>::velocity, py::const_),
+            "velocity (vx, vy) the last kept vertex was reached at")
+        .def("__len__", &DeadReckoning<3>::size)
+        //
+        ;
+
+    auto doc = R"pbdoc(
+        Compresses trajectories by dead reckoning (tracks in parallel), rows
+        are (x, y, t) or (x, y, z, t), timestamps non-decreasing: a vertex is
+        kept only if it deviates by more than epsilon from the position
+        predicted from the last kept vertex A and the velocity v A was reached
+        at (from the vertex before it): A + v * (t - A.t). Every dropped vertex
+        is within epsilon (euclidean, over x, y (, z)) of its prediction, the
+        first and last vertices are kept. O(1) per vertex, deviations computed
+        for blocks of vertices at once.
+        return_velocities (dead_reckoning): return (tracks, velocities), v of
+            each kept vertex (Kx2 or Kx3), to predict the dropped positions.
+    )pbdoc";
+    def_dead_reckoning<3>(m, doc);
+    def_dead_reckoning<4>(m, doc);
+}
+} // namespace fast_rdp
+
+#endif
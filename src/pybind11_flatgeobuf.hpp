@@ -0,0 +1,102 @@
+#ifndef FAST_RDP_PYBIND11_FLATGEOBUF_HPP
+#define FAST_RDP_PYBIND11_FLATGEOBUF_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "flatgeobuf.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+inline void bind_flatgeobuf(py::module &m)
+{
+    m.def(
+        "simplify_flatgeobuf",
+        [](const std::string &input_path, const std::string &output_path,
+           double epsilon, bool recursive, const std::string &metric,
+           bool preserve_topology, bool index, int num_threads) {
+            return simplify_flatgeobuf(input_path, output_path, epsilon,
+                                       recursive, distance_metric(metric),
+                                       preserve_topology, index, num_threads);
+        },
+        R"pbdoc(
+        Simplifies a FlatGeobuf file into a new FlatGeobuf file.
+
+        The input is memory-mapped and simplified in place (no geometry
+        objects), features in parallel on num_threads workers. linestrings
+        and polygon rings are simplified, rings are not collapsed below 4
+        points, properties, columns and crs are copied as is.
+
+        index: write a packed r-tree index of the simplified bboxes (features
+            in hilbert order), else no index and input order.
+        return the number of features.
+    )pbdoc",
+        "input_path"_a, "output_path"_a, py::kw_only(), "epsilon"_a = 0.0,
+        "recursive"_a = true, "metric"_a = "segment",
+        "preserve_topology"_a = false, "index"_a = true, "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+
+    auto write_doc = R"pbdoc(
+        Writes polylines (Nx3 with z, or Nx2) as FlatGeobuf LineString
+        features (no properties), with a packed r-tree index if index.
+    )pbdoc";
+    m.def(
+        "write_flatgeobuf",
+        [](const std::string &path, const std::vector<RowVectors> &lines,
+           bool index, int num_threads) {
+            write_flatgeobuf(path, lines, true, index, num_threads);
+        },
+        write_doc, "path"_a, "lines"_a, py::kw_only(), "index"_a = true,
+        "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "write_flatgeobuf",
+        [](const std::string &path, const std::vector<RowVectorsNx2> &lines,
+           bool index, int num_threads) {
+            std::vector<RowVectors> xyzs;
+            xyzs.reserve(lines.size());
+            for (auto &line : lines) {
+                xyzs.push_back(to_Nx3(line));
+            }
+            write_flatgeobuf(path, xyzs, false, index, num_threads);
+        },
+        write_doc, "path"_a, "lines"_a, py::kw_only(), "index"_a = true,
+        "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>());
+
+    m.def(
+        "read_flatgeobuf",
+        [](const std::string &path) {
+            bool has_z = false;
+            std::vector<std::vector<RowVectors>> features;
+            {
+                py::gil_scoped_release release;
+                features = read_flatgeobuf(path, has_z);
+            }
+            py::list ret;
+            for (auto &parts : features) {
+                py::list feature;
+                for (auto &part : parts) {
+                    if (has_z) {
+                        feature.append(py::cast(std::move(part)));
+                    } else {
+                        RowVectorsNx2 xys = part.leftCols(2);
+                        feature.append(py::cast(std::move(xys)));
+                    }
+                }
+                ret.append(feature);
+            }
+            return ret;
+        },
+        R"pbdoc(
+        Reads the coordinates of a FlatGeobuf file: for each feature (in file
+        order), the list of its parts (lines, rings, points) as Nx3 arrays if
+        the file has z, else Nx2.
+    )pbdoc",
+        "path"_a);
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef FAST_RDP_PYBIND11_GEOJSON_HPP
+#define FAST_RDP_PYBIND11_GEOJSON_HPP
+
+#include <pybind11/pybind11.h>
+
+#include "geojson.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+inline void bind_geojson(py::module &m)
+{
+    m.def(
+        "simplify_geojson",
+        [](const std::string &input_path, const std::string &output_path,
+           double epsilon, bool recursive, const std::string &metric,
+           bool preserve_topology, int window, int num_threads) {
+            return simplify_geojson(input_path, output_path, epsilon,
+                                    recursive, distance_metric(metric),
+                                    preserve_topology, window, num_threads);
+        },
+        R"pbdoc(
+        Simplifies a GeoJSON FeatureCollection file, streaming.
+
+        Features are parsed and simplified in batches of `window` features
+        on num_threads workers, written out in input order, so memory is
+        bounded by the window, not the file size. linestrings and polygon
+        rings are simplified, rings are not collapsed below 4 points,
+        properties and other members are copied as is.
+
+        preserve_topology: parts of a geometry don't cross each other.
+        return the number of features.
+    )pbdoc",
+        "input_path"_a, "output_path"_a, py::kw_only(), "epsilon"_a = 0.0,
+        "recursive"_a = true, "metric"_a = "segment",
+        "preserve_topology"_a = false, "window"_a = 1024, "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef FAST_RDP_PYBIND11_GEOJSONVT_HPP
+#define FAST_RDP_PYBIND11_GEOJSONVT_HPP
+
+#include "geojsonvt.hpp"
+#include "mvt.hpp"
+
+#include <mapbox/geojson.hpp>
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+using TilePoints = Eigen::Matrix<int, Eigen::Dynamic, 2, Eigen::RowMajor>;
+
+// tile geometry (int16 tile coords) -> geojson-like {"type", "coordinates"},
+// with Nx2 arrays as leaves
+struct TileGeometryToPython
+{
+    using Geometry = mapbox::geometry::geometry<int16_t>;
+
+    template <typename Points> static TilePoints points(const Points &points)
+    {
+        TilePoints xys(points.size(), 2);
+        for (int i = 0, N = points.size(); i < N; ++i) {
+            xys(i, 0) = points[i].x;
+            xys(i, 1) = points[i].y;
+        }
+        return xys;
+    }
+    template <typename Lines> static py::list lines(const Lines &lines)
+    {
+        py::list ret;
+        for (const auto &line : lines) {
+            ret.append(points(line));
+        }
+        return ret;
+    }
+    static py::dict feature(const char *type, py::object coordinates)
+    {
+        return py::dict("type"_a = type, "coordinates"_a = coordinates);
+    }
+
+    py::object operator()(const mapbox::geometry::empty &) const
+    {
+        return py::none();
+    }
+    py::object operator()(const mapbox::geometry::point<int16_t> &p) const
+    {
+        return feature("Point", py::cast(Eigen::Vector2i(p.x, p.y)));
+    }
+    py::object
+    operator()(const mapbox::geometry::multi_point<int16_t> &mp) const
+    {
+        return feature("MultiPoint", py::cast(points(mp)));
+    }
+    py::object
+    operator()(const mapbox::geometry::line_string<int16_t> &ls) const
+    {
+        return feature("LineString", py::cast(points(ls)));
+    }
+    py::object
+    operator()(const mapbox::geometry::multi_line_string<int16_t> &mls) const
+    {
+        return feature("MultiLineString", lines(mls));
+    }
+    py::object operator()(const mapbox::geometry::polygon<int16_t> &p) const
+    {
+        return feature("Polygon", lines(p));
+    }
+    py::object
+    operator()(const mapbox::geometry::multi_polygon<int16_t> &mp) const
+    {
+        py::list polygons;
+        for (const auto &polygon : mp) {
+            polygons.append(lines(polygon));
+        }
+        return feature("MultiPolygon", polygons);
+    }
+    py::object operator()(
+        const mapbox::geometry::geometry_collection<int16_t> &gc) const
+    {
+        py::list geometries;
+        for (const auto &g : gc) {
+            geometries.append(Geometry::visit(g, *this));
+        }
+        return py::dict("type"_a = "GeometryCollection",
+                        "geometries"_a = geometries);
+    }
+};
+
+inline py::dict tile_to_python(const vt::Tile &tile)
+{
+    py::list features;
+    for (const auto &feature : tile.features) {
+        features.append(TileGeometryToPython::Geometry::visit(
+            feature.geometry, TileGeometryToPython{}));
+    }
+    return py::dict("num_points"_a = tile.num_points,
+                    "num_simplified"_a = tile.num_simplified,
+                    "features"_a = features);
+}
+
+inline void bind_geojsonvt(py::module &m)
+{
+    py::class_<GeoJSONVT>(m, "GeoJSONVT", R"pbdoc(
+        geojson-vt tile index (mapbox/geojson-vt), simplified by the rdp core
+        and built in parallel (features, tiles of a zoom level, quadrants).
+
+        geojson: a GeoJSON string (FeatureCollection, Feature or geometry).
+        options are the same as geojson-vt's.
+    )pbdoc")
+        .def(py::init([](const std::string &geojson, double tolerance,
+                         int extent, int buffer, int max_zoom,
+                         int index_max_zoom, int index_max_points,
+                         bool line_metrics, bool generate_id,
+                         int num_threads) {
+                 vt::Options options;
+                 options.tolerance = tolerance;
+                 options.extent = extent;
+                 options.buffer = buffer;
+                 options.maxZoom = max_zoom;
+                 options.indexMaxZoom = index_max_zoom;
+                 options.indexMaxPoints = index_max_points;
+                 options.lineMetrics = line_metrics;
+                 options.generateId = generate_id;
+                 return std::make_unique<GeoJSONVT>(
+                     mapbox::geojson::parse(geojson), options, num_threads);
+             }),
+             "geojson"_a, py::kw_only(), "tolerance"_a = 3.0,
+             "extent"_a = 4096, "buffer"_a = 64, "max_zoom"_a = 18,
+             "index_max_zoom"_a = 5, "index_max_points"_a = 100000,
+             "line_metrics"_a = false, "generate_id"_a = false,
+             "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>())
+        .def(
+            "tile",
+            [](GeoJSONVT &self, int z, int64_t x, int64_t y) {
+                const vt::Tile *tile = nullptr;
+                {
+                    py::gil_scoped_release release;
+                    tile = &self.tile(z, x, y);
+                }
+                return tile_to_python(*tile);
+            },
+            "z"_a, "x"_a, "y"_a,
+            "tile z/x/y: {num_points, num_simplified, features}, features "
+            "are geojson-like geometries in tile coordinates")
+        .def("tile_ids", &GeoJSONVT::tile_ids,
+             "z/x/y of tiles built so far, sorted")
+        .def(
+            "tile_mvt",
+            [](GeoJSONVT &self, int z, int64_t x, int64_t y,
+               const std::string &layer) {
+                std::string bytes;
+                {
+                    py::gil_scoped_release release;
+                    bytes = encode_mvt(self.tile(z, x, y).features, layer,
+                                       self.options.extent);
+                }
+                return py::bytes(bytes);
+            },
+            "z"_a, "x"_a, "y"_a, py::kw_only(), "layer"_a = "geojsonLayer",
+            "tile z/x/y as Mapbox Vector Tile bytes (one layer)")
+        .def(
+            "tiles_mvt",
+            [](GeoJSONVT &self,
+               const std::vector<std::tuple<int, int64_t, int64_t>> &ids,
+               const std::string &layer) {
+                const int N = ids.size();
+                std::vector<std::string> tiles(N);
+                {
+                    py::gil_scoped_release release;
+                    // drilling down changes the index, tiles are looked up
+                    // first, then encoded in parallel
+                    std::vector<const vt::Tile *> found(N);
+                    for (int i = 0; i < N; ++i) {
+                        found[i] = &self.tile(std::get<0>(ids[i]),
+                                              std::get<1>(ids[i]),
+                                              std::get<2>(ids[i]));
+                    }
+                    parallel_for(
+                        N,
+                        [&](int i) {
+                            tiles[i] = encode_mvt(found[i]->features, layer,
+                                                  self.options.extent);
+                        },
+                        self.num_threads);
+                }
+                py::list ret;
+                for (auto &tile : tiles) {
+                    ret.append(py::bytes(tile));
+                }
+                return ret;
+            },
+            "ids"_a, py::kw_only(), "layer"_a = "geojsonLayer",
+            "tiles of z/x/y ids as Mapbox Vector Tile bytes, encoded in "
+            "parallel")
+        .def_property_readonly("total", &GeoJSONVT::total)
+        .def_property_readonly("stats", &GeoJSONVT::stats)
+        //
+        ;
+
+    m.def(
+        "encode_mvt",
+        [](const std::vector<std::vector<RowVectorsNx2>> &tiles,
+           const std::string &layer, int extent, int num_threads) {
+            std::vector<std::string> encoded;
+            {
+                py::gil_scoped_release release;
+                encoded = encode_mvt_lines(tiles, layer, extent, num_threads);
+            }
+            py::list ret;
+            for (auto &tile : encoded) {
+                ret.append(py::bytes(tile));
+            }
+            return ret;
+        },
+        R"pbdoc(
+        Encodes tiles of simplified linestrings as Mapbox Vector Tiles.
+
+        tiles: for each tile, its lines as Nx2 arrays in tile coordinates
+            (rounded to integers), tiles are encoded in parallel.
+        return a list of tile bytes (one layer, no properties).
+    )pbdoc",
+        "tiles"_a, py::kw_only(), "layer"_a = "lines", "extent"_a = 4096,
+        "num_threads"_a = 0);
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef FAST_RDP_PYBIND11_MULTIRES_HPP
+#define FAST_RDP_PYBIND11_MULTIRES_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "multires.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+// 2d lines are stored as Nx3 (to_Nx3), y is column 2 for vertical metric
+inline int y_column(const MultiResolutionIndex &index)
+{
+    return index.metric() == DistanceMetric::Vertical ? 2 : 1;
+}
+
+inline py::object to_python(const MultiResolutionIndex &index,
+                            const RowVectors &coords)
+{
+    if (index.dims() == 3) {
+        return py::cast(coords);
+    }
+    RowVectorsNx2 xys(coords.rows(), 2);
+    xys.col(0) = coords.col(0);
+    xys.col(1) = coords.col(y_column(index));
+    return py::cast(std::move(xys));
+}
+
+inline void bind_multires(py::module &m)
+{
+    auto build_doc = R"pbdoc(
+        Builds a multi-resolution index of lines (Nx3 or Nx2) at path.
+
+        rdp importance of every vertex is computed once (lines in parallel),
+        coordinates, importance and line offsets are serialized with cista,
+        so MultiResolutionIndex(path) can mmap it and extract the lines at any
+        epsilon >= min_epsilon by a threshold scan (same output as rdp).
+    )pbdoc";
+    m.def(
+        "build_multires_index",
+        [](const std::string &path, const std::vector<RowVectors> &lines,
+           double min_epsilon, const std::string &metric, int num_threads) {
+            build_multires_index(path, lines, 3, min_epsilon,
+                                 distance_metric(metric), num_threads);
+        },
+        build_doc, "path"_a, "lines"_a, py::kw_only(), "min_epsilon"_a = 0.0,
+        "metric"_a = "segment", "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "build_multires_index",
+        [](const std::string &path, const std::vector<RowVectorsNx2> &lines,
+           double min_epsilon, const std::string &metric, int num_threads) {
+            auto dist = distance_metric(metric);
+            std::vector<RowVectors> xyzs;
+            xyzs.reserve(lines.size());
+            for (auto &line : lines) {
+                xyzs.push_back(to_Nx3(line, dist));
+            }
+            build_multires_index(path, xyzs, 2, min_epsilon, dist,
+                                 num_threads);
+        },
+        build_doc, "path"_a, "lines"_a, py::kw_only(), "min_epsilon"_a = 0.0,
+        "metric"_a = "segment", "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+
+    py::class_<MultiResolutionIndex>(m, "MultiResolutionIndex", R"pbdoc(
+        A memory-mapped multi-resolution index (see build_multires_index),
+        read in place without deserialization.
+    )pbdoc")
+        .def(py::init<const std::string &>(), "path"_a)
+        .def("__len__", &MultiResolutionIndex::size)
+        .def_property_readonly("dims", &MultiResolutionIndex::dims)
+        .def_property_readonly("min_epsilon",
+                               &MultiResolutionIndex::min_epsilon)
+        .def(
+            "coords",
+            [](py::object self, int i) {
+                const auto &index = self.cast<const MultiResolutionIndex &>();
+                auto coords = index.coords(i);
+                const int cols = index.dims();
+                const ssize_t stride = sizeof(double);
+                // read-only view into the mapping, kept alive by self
+                py::array_t<double> view(
+                    {ssize_t(coords.rows()), ssize_t(cols)},
+                    {3 * stride, cols == 3 ? stride : y_column(index) * stride},
+                    coords.data(), self);
+                py::detail::array_proxy(view.ptr())->flags &=
+                    ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+                return view;
+            },
+            "i"_a, "line i (original vertices), a read-only view, no copy")
+        .def(
+            "importance",
+            [](py::object self, int i) {
+                const auto &index = self.cast<const MultiResolutionIndex &>();
+                auto importance = index.importance(i);
+                py::array_t<double> view(importance.size(), importance.data(),
+                                         self);
+                py::detail::array_proxy(view.ptr())->flags &=
+                    ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+                return view;
+            },
+            "i"_a,
+            "squared distance each vertex of line i is kept at (endpoints: "
+            "inf), a read-only view")
+        .def("mask", &MultiResolutionIndex::mask, "i"_a, py::kw_only(),
+             "epsilon"_a, "rdp mask of line i at epsilon")
+        .def(
+            "simplify",
+            [](const MultiResolutionIndex &self, int i, double epsilon) {
+                return to_python(self, self.simplify(i, epsilon));
+            },
+            "i"_a, py::kw_only(), "epsilon"_a, "line i simplified at epsilon")
+        .def(
+            "simplify",
+            [](const MultiResolutionIndex &self, double epsilon,
+               int num_threads) {
+                std::vector<RowVectors> lines;
+                {
+                    py::gil_scoped_release release;
+                    lines = self.simplify(epsilon, num_threads);
+                }
+                py::list ret;
+                for (auto &line : lines) {
+                    ret.append(to_python(self, line));
+                }
+                return ret;
+            },
+            py::kw_only(), "epsilon"_a, "num_threads"_a = 0,
+            "all lines simplified at epsilon (in parallel)")
+        //
+        ;
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef FAST_RDP_PYBIND11_NETWORK_HPP
+#define FAST_RDP_PYBIND11_NETWORK_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "network.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+inline const std::vector<RowVectors> &
+to_Nx3(const std::vector<RowVectors> &lines, DistanceMetric)
+{
+    return lines;
+}
+
+inline std::vector<RowVectors> to_Nx3(const std::vector<RowVectorsNx2> &lines,
+                                      DistanceMetric metric)
+{
+    std::vector<RowVectors> xyzs;
+    xyzs.reserve(lines.size());
+    for (auto &line : lines) {
+        xyzs.push_back(to_Nx3(line, metric));
+    }
+    return xyzs;
+}
+
+template <typename Coords>
+std::vector<Coords> select_by_masks(const std::vector<Coords> &lines,
+                                    const std::vector<Eigen::VectorXi> &masks)
+{
+    std::vector<Coords> ret;
+    ret.reserve(lines.size());
+    for (int i = 0, N = lines.size(); i < N; ++i) {
+        ret.push_back(select_by_mask(lines[i], masks[i]));
+    }
+    return ret;
+}
+
+// <name> & <name>_mask for lists of Nx3 or Nx2 coords
+template <typename Coords>
+void def_rdp_batch(py::module &m, const std::string &name, const char *doc,
+                   bool keep_shared_vertices)
+{
+    auto masks = [keep_shared_vertices](const std::vector<Coords> &lines,
+                                        double epsilon, bool recursive,
+                                        const std::string &metric,
+                                        bool preserve_topology,
+                                        int num_threads) {
+        auto dist = distance_metric(metric);
+        return douglas_simplify_batch_masks(
+            to_Nx3(lines, dist), epsilon, recursive, dist,
+            keep_shared_vertices, preserve_topology, num_threads);
+    };
+    m.def((name + "_mask").c_str(), masks, doc, "lines"_a, py::kw_only(),
+          "epsilon"_a = 0.0, "recursive"_a = true, "metric"_a = "segment",
+          "preserve_topology"_a = false, "num_threads"_a = 0,
+          py::call_guard<py::gil_scoped_release>());
+    m.def(
+        name.c_str(),
+        [masks](const std::vector<Coords> &lines, double epsilon,
+                bool recursive, const std::string &metric,
+                bool preserve_topology, int num_threads) {
+            return select_by_masks(lines,
+                                   masks(lines, epsilon, recursive, metric,
+                                         preserve_topology, num_threads));
+        },
+        doc, "lines"_a, py::kw_only(), "epsilon"_a = 0.0,
+        "recursive"_a = true, "metric"_a = "segment",
+        "preserve_topology"_a = false, "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+}
+
+inline void bind_network(py::module &m)
+{
+    auto rdp_batch_doc = R"pbdoc(
+        Simplifies a list of polylines in parallel.
+
+        preserve_topology: refine the output until simplified lines do not
+            cross each other (or themselves) in xy-plane, only spans involved
+            in a crossing are refined.
+    )pbdoc";
+    def_rdp_batch<RowVectors>(m, "rdp_batch", rdp_batch_doc, false);
+    def_rdp_batch<RowVectorsNx2>(m, "rdp_batch", rdp_batch_doc, false);
+
+    auto rdp_network_doc = R"pbdoc(
+        Simplifies polylines of a network (e.g. road graph) in parallel.
+
+        Vertices shared by more than one line (junctions, common endpoints,
+        matched by exact coordinates) are always kept, so the simplified
+        network stays connected.
+
+        preserve_topology: see rdp_batch.
+    )pbdoc";
+    def_rdp_batch<RowVectors>(m, "rdp_network", rdp_network_doc, true);
+    def_rdp_batch<RowVectorsNx2>(m, "rdp_network", rdp_network_doc, true);
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FAST_RDP_PYBIND11_SIMPLIFICATION_ERROR_HPP
+#define FAST_RDP_PYBIND11_SIMPLIFICATION_ERROR_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+
+#include "simplification_error.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+inline void bind_simplification_error(py::module &m)
+{
+    py::class_<SimplificationError>(m, "SimplificationError")
+        .def_readonly("original_to_simplified",
+                      &SimplificationError::original_to_simplified,
+                      "directed Hausdorff distance, max deviation of the "
+                      "original vertices from the simplified line")
+        .def_readonly("simplified_to_original",
+                      &SimplificationError::simplified_to_original,
+                      "directed Hausdorff distance, max deviation of any "
+                      "point of the simplified line from the original")
+        .def_readonly("farthest_index", &SimplificationError::farthest_index,
+                      "original vertex at original_to_simplified")
+        .def_readonly("hausdorff", &SimplificationError::hausdorff,
+                      "symmetric Hausdorff distance")
+        .def_readonly("frechet", &SimplificationError::frechet,
+                      "discrete Fréchet distance (nan if not computed)")
+        .def("__repr__",
+             [](const SimplificationError &e) {
+                 return "SimplificationError(hausdorff=" +
+                        std::to_string(e.hausdorff) +
+                        ", original_to_simplified=" +
+                        std::to_string(e.original_to_simplified) +
+                        ", simplified_to_original=" +
+                        std::to_string(e.simplified_to_original) +
+                        ", frechet=" + std::to_string(e.frechet) + ")";
+             })
+        //
+        ;
+
+    auto doc = R"pbdoc(
+        Max deviation between a line and its simplification (Nx3 or Nx2):
+        directed & symmetric Hausdorff distances (original vertices to the
+        simplified line, every point of the simplified segments to the
+        original line, both indexed in a flatbush, in parallel on
+        num_threads), and the discrete Fréchet distance if frechet: O(N*M)
+        time (e.g. seconds for 10^5 x 10^4 vertices), O(N+M) memory, blocks
+        of its table in parallel on num_threads.
+    )pbdoc";
+    m.def("simplification_error", &simplification_error, doc, "original"_a,
+          "simplified"_a, py::kw_only(), "frechet"_a = false,
+          "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "simplification_error",
+        [](const RowVectorsNx2 &original, const RowVectorsNx2 &simplified,
+           bool frechet, int num_threads) {
+            return simplification_error(to_Nx3(original), to_Nx3(simplified),
+                                        frechet, num_threads);
+        },
+        doc, "original"_a, "simplified"_a, py::kw_only(), "frechet"_a = false,
+        "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>());
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef FAST_RDP_PYBIND11_SLEEVE_HPP
+#define FAST_RDP_PYBIND11_SLEEVE_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+
+#include "sleeve.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+inline void bind_sleeve(py::module &m)
+{
+    py::class_<SleeveSimplifier>(m, "SleeveSimplifier", R"pbdoc(
+        Online (push-based) simplifier, one pass, O(1) memory: vertices are
+        pushed one by one, push returns the index of the vertex it makes a key
+        vertex (-1 if none), finish() the index of the last vertex (-1 if it
+        already is a key vertex). Every dropped vertex is within epsilon of its
+        output segment, as with rdp (see sleeve).
+    )pbdoc")
+        .def(py::init<double>(), py::kw_only(), "epsilon"_a)
+        .def("push", &SleeveSimplifier::push, "P"_a)
+        .def(
+            "push",
+            [](SleeveSimplifier &self, const Eigen::Vector2d &P) {
+                return self.push({P[0], P[1], 0.0});
+            },
+            "P"_a)
+        .def("finish", &SleeveSimplifier::finish)
+        .def_property_readonly("key", &SleeveSimplifier::key,
+                               "last key vertex (3d)")
+        .def("__len__", &SleeveSimplifier::size)
+        //
+        ;
+
+    auto sleeve_doc = R"pbdoc(
+        Simplifies a line (Nx3 or Nx2) in one pass, O(N) time (Zhao-Saalfeld
+        sleeve fitting): the output segment grows while it stays within epsilon
+        of every vertex it skips. Same epsilon guarantee as rdp (distance to
+        the output segment), greedy instead of global, so usually a few more
+        vertices are kept. 3d lines are a bit more conservative than 2d.
+    )pbdoc";
+    m.def(
+        "sleeve",
+        [](const Eigen::Ref<const RowVectors> &coords, double epsilon) {
+            return select_by_mask(coords,
+                                  sleeve_simplify_mask(coords, epsilon));
+        },
+        sleeve_doc, "coords"_a, py::kw_only(), "epsilon"_a = 0.0,
+        py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "sleeve",
+        [](const Eigen::Ref<const RowVectorsNx2> &coords, double epsilon) {
+            return select_by_mask(
+                coords, sleeve_simplify_mask(to_Nx3(coords), epsilon));
+        },
+        sleeve_doc, "coords"_a, py::kw_only(), "epsilon"_a = 0.0,
+        py::call_guard<py::gil_scoped_release>());
+    m.def("sleeve_mask", &sleeve_simplify_mask, "coords"_a, py::kw_only(),
+          "epsilon"_a = 0.0, "mask of sleeve (Nx3)",
+          py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "sleeve_mask",
+        [](const Eigen::Ref<const RowVectorsNx2> &coords, double epsilon) {
+            return sleeve_simplify_mask(to_Nx3(coords), epsilon);
+        },
+        "coords"_a, py::kw_only(), "epsilon"_a = 0.0, "mask of sleeve (Nx2)",
+        py::call_guard<py::gil_scoped_release>());
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef FAST_RDP_PYBIND11_SQUISH_HPP
+#define FAST_RDP_PYBIND11_SQUISH_HPP
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "squish.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+// squish & squish_mask for lists of Nx3 (x, y, t) or Nx4 (x, y, z, t) tracks
+template <int Dims> void def_squish(py::module &m, const char *doc)
+{
+    using Coords = typename SquishE<Dims>::Coords;
+    m.def("squish_mask", &squish_masks<Dims>, doc, "tracks"_a, py::kw_only(),
+          "ratio"_a = 1.0, "max_error"_a = 0.0, "capacity"_a = 0,
+          "num_threads"_a = 0, py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "squish",
+        [](const std::vector<Coords> &tracks, double ratio, double max_error,
+           int capacity, int num_threads) {
+            auto masks = squish_masks<Dims>(tracks, ratio, max_error,
+                                            capacity, num_threads);
+            std::vector<Coords> ret;
+            ret.reserve(tracks.size());
+            for (int i = 0, N = tracks.size(); i < N; ++i) {
+                ret.push_back(select_by_mask(tracks[i], masks[i]));
+            }
+            return ret;
+        },
+        doc, "tracks"_a, py::kw_only(), "ratio"_a = 1.0, "max_error"_a = 0.0,
+        "capacity"_a = 0, "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+}
+
+inline void bind_squish(py::module &m)
+{
+    py::class_<SquishE<3>>(m, "SquishE", R"pbdoc(
+        SQUISH-E compressor of one track of (x, y, t) vertices, pushed one by
+        one, in a bounded buffer (see squish). indices() & coords() are the
+        compressed track so far.
+    )pbdoc")
+        .def(py::init<double, double, int>(), py::kw_only(), "ratio"_a = 1.0,
+             "max_error"_a = 0.0, "capacity"_a = 0)
+        .def("push", &SquishE<3>::push, "P"_a)
+        .def("indices", &SquishE<3>::indices)
+        .def("coords", &SquishE<3>::coords)
+        .def("__len__", &SquishE<3>::size)
+        .def_property_readonly("num_pushed", &SquishE<3>::num_pushed)
+        .def_property_readonly("error_bound", &SquishE<3>::error_bound,
+                               "upper bound of the SED error")
+        //
+        ;
+
+    auto doc = R"pbdoc(
+        Compresses trajectories with SQUISH-E (tracks in parallel), rows are
+        (x, y, t) or (x, y, z, t), timestamps non-decreasing. Each track keeps
+        a buffer of vertices with a heap of SED error bounds, the vertex of
+        lowest bound is dropped while:
+            ratio: the buffer holds more than 1/ratio of the vertices seen so
+                far (compression ratio, 1: none)
+            max_error: its SED error bound is <= max_error
+            capacity: the buffer holds more than capacity vertices (fixed
+                memory per track, 0: none)
+        the SED error stays <= max_error unless ratio or capacity force more.
+    )pbdoc";
+    def_squish<3>(m, doc);
+    def_squish<4>(m, doc);
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef FAST_RDP_PYBIND11_TRACE_HPP
+#define FAST_RDP_PYBIND11_TRACE_HPP
+
+#include <pybind11/pybind11.h>
+
+#include "trace.hpp"
+
+namespace fast_rdp
+{
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+inline void bind_trace(py::module &m)
+{
+    m.def("start_trace", &trace::start, R"pbdoc(
+        Starts recording one event per parallel task (batch lines, geojson &
+        flatgeobuf features, multi-resolution index lines), previous events
+        are dropped. See fast_rdp.trace().
+    )pbdoc");
+    m.def(
+        "stop_trace",
+        [](const std::string &path) {
+            trace::stop();
+            return trace::dump(path);
+        },
+        R"pbdoc(
+        Stops recording, writes the events to path as Chrome trace-event JSON
+        (open in https://ui.perfetto.dev), one track per thread.
+        return the number of events.
+    )pbdoc",
+        "path"_a, py::call_guard<py::gil_scoped_release>());
+}
+} // namespace fast_rdp
+
+#endif
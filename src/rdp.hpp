@@ -0,0 +1,911 @@
+#ifndef FAST_RDP_RDP_HPP
+#define FAST_RDP_RDP_HPP
+
+// https://github.com/microsoft/vscode-cpptools/issues/9692
+#if __INTELLISENSE__
+#undef __ARM_NEON
+#undef __ARM_NEON__
+#endif
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fast_rdp
+{
+using RowVectors = Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>;
+using RowVectorsNx3 = RowVectors;
+using RowVectorsNx2 = Eigen::Matrix<double, Eigen::Dynamic, 2, Eigen::RowMajor>;
+using RowVectorsNx4 = Eigen::Matrix<double, Eigen::Dynamic, 4, Eigen::RowMajor>;
+
+// distance to segment AB, P is clamped to the segment ends
+struct LineSegment
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    const Eigen::Vector3d A, B, AB;
+    const double len2, inv_len2;
+    LineSegment(const Eigen::Vector3d &a, const Eigen::Vector3d &b)
+        : A(a), B(b), AB(b - a), //
+          len2((b - a).squaredNorm()), inv_len2(1.0 / len2)
+    {
+    }
+    double distance2(const Eigen::Vector3d &P) const
+    {
+        double dot = (P - A).dot(AB);
+        if (dot <= 0) {
+            return (P - A).squaredNorm();
+        } else if (dot >= len2) {
+            return (P - B).squaredNorm();
+        }
+        // P' = A + dot/length * normed(AB)
+        //    = A + dot * AB / (length^2)
+        return (A + (dot * inv_len2 * AB) - P).squaredNorm();
+    }
+    double distance(const Eigen::Vector3d &P) const
+    {
+        return std::sqrt(distance2(P));
+    }
+};
+
+// distance to the infinite line through A and B, same as `pldist` of the
+// python rdp package (https://github.com/fhirschmann/rdp)
+struct InfiniteLine
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    const Eigen::Vector3d A, AB;
+    const double len2, inv_len2;
+    InfiniteLine(const Eigen::Vector3d &a, const Eigen::Vector3d &b)
+        : A(a), AB(b - a), //
+          len2((b - a).squaredNorm()), inv_len2(1.0 / len2)
+    {
+    }
+    double distance2(const Eigen::Vector3d &P) const
+    {
+        if (len2 == 0.0) {
+            return (P - A).squaredNorm();
+        }
+        return AB.cross(P - A).squaredNorm() * inv_len2;
+    }
+    double distance(const Eigen::Vector3d &P) const
+    {
+        return std::sqrt(distance2(P));
+    }
+};
+
+// distance to segment AB in xy-plane, z is ignored
+struct HorizontalSegment
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    const Eigen::Vector2d A, B, AB;
+    const double len2, inv_len2;
+    HorizontalSegment(const Eigen::Vector3d &a, const Eigen::Vector3d &b)
+        : A(a.head<2>()), B(b.head<2>()), AB(B - A), //
+          len2(AB.squaredNorm()), inv_len2(1.0 / len2)
+    {
+    }
+    double distance2(const Eigen::Vector3d &P) const
+    {
+        Eigen::Vector2d AP = P.head<2>() - A;
+        double dot = AP.dot(AB);
+        if (dot <= 0) {
+            return AP.squaredNorm();
+        } else if (dot >= len2) {
+            return (P.head<2>() - B).squaredNorm();
+        }
+        return (dot * inv_len2 * AB - AP).squaredNorm();
+    }
+    double distance(const Eigen::Vector3d &P) const
+    {
+        return std::sqrt(distance2(P));
+    }
+};
+
+// |dz| between P and segment AB, measured where P projects onto AB in
+// xy-plane (clamped to the segment ends), e.g. for elevation profiles
+struct VerticalSegment
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    const Eigen::Vector3d A, AB;
+    const double len2, inv_len2; // of xy-projection
+    VerticalSegment(const Eigen::Vector3d &a, const Eigen::Vector3d &b)
+        : A(a), AB(b - a), //
+          len2(AB.head<2>().squaredNorm()), inv_len2(1.0 / len2)
+    {
+    }
+    double distance2(const Eigen::Vector3d &P) const
+    {
+        double dot = (P - A).head<2>().dot(AB.head<2>());
+        double t = 0.0;
+        if (dot <= 0) {
+            t = 0.0;
+        } else if (dot >= len2) {
+            t = 1.0;
+        } else {
+            t = dot * inv_len2;
+        }
+        double dz = P[2] - (A[2] + t * AB[2]);
+        return dz * dz;
+    }
+    double distance(const Eigen::Vector3d &P) const
+    {
+        return std::sqrt(distance2(P));
+    }
+};
+
+// horizontal & vertical deviations to segment AB in one pass, both measured
+// at the xy-projection of P onto AB (clamped to the segment ends), distance2
+// is normalized by the tolerances: max(dxy^2/epsilon_xy^2, dz^2/epsilon_z^2),
+// i.e. P is significant (> 1.0) if it exceeds either bound
+struct AnisotropicSegment
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    const Eigen::Vector3d A, AB;
+    const double len2, inv_len2; // of xy-projection
+    const double inv_epsilon_xy2, inv_epsilon_z2;
+    AnisotropicSegment(const Eigen::Vector3d &a, const Eigen::Vector3d &b,
+                       double inv_epsilon_xy2, double inv_epsilon_z2)
+        : A(a), AB(b - a), //
+          len2(AB.head<2>().squaredNorm()), inv_len2(1.0 / len2),
+          inv_epsilon_xy2(inv_epsilon_xy2), inv_epsilon_z2(inv_epsilon_z2)
+    {
+    }
+    // squared deviations, [dxy^2, dz^2]
+    Eigen::Vector2d deviation2(const Eigen::Vector3d &P) const
+    {
+        Eigen::Vector3d AP = P - A;
+        double dot = AP.head<2>().dot(AB.head<2>());
+        double t = 0.0;
+        if (dot <= 0) {
+            t = 0.0;
+        } else if (dot >= len2) {
+            t = 1.0;
+        } else {
+            t = dot * inv_len2;
+        }
+        Eigen::Vector3d d = t * AB - AP;
+        return {d.head<2>().squaredNorm(), d[2] * d[2]};
+    }
+    double distance2(const Eigen::Vector3d &P) const
+    {
+        Eigen::Vector2d d2 = deviation2(P);
+        return std::max(scaled(d2[0], inv_epsilon_xy2),
+                        scaled(d2[1], inv_epsilon_z2));
+    }
+    double distance(const Eigen::Vector3d &P) const
+    {
+        return std::sqrt(distance2(P));
+    }
+
+  private:
+    // zero deviation never exceeds the bound, even if the bound is zero
+    static double scaled(double dist2, double inv_epsilon2)
+    {
+        return dist2 > 0 ? dist2 * inv_epsilon2 : 0.0;
+    }
+};
+
+// synchronized euclidean distance (SED) of trajectories, Dims - 1 spatial
+// coordinates and time last (x, y, t or x, y, z, t): distance between P and
+// the position interpolated on AB at P's timestamp (TD-TR), no clamping nor
+// branch in the scan. Zero duration segments: the position of A.
+template <int Dims> struct SynchronizedSegment
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    using Vector = Eigen::Matrix<double, Dims, 1>;
+    const Vector A, AB;
+    const double inv_dt;
+    SynchronizedSegment(const Vector &a, const Vector &b)
+        : A(a), AB(b - a), //
+          inv_dt(AB[Dims - 1] > 0 ? 1.0 / AB[Dims - 1] : 0.0)
+    {
+    }
+    double distance2(const Vector &P) const
+    {
+        double t = (P[Dims - 1] - A[Dims - 1]) * inv_dt;
+        return (A + t * AB - P).template head<Dims - 1>().squaredNorm();
+    }
+    double distance(const Vector &P) const { return std::sqrt(distance2(P)); }
+};
+
+// A metric policy builds the per-segment distance functor used by the scan.
+// It is a template parameter of the simplification core, so distance2 is
+// inlined into the loop (no virtual call, no python callback).
+template <typename Segment> struct MetricPolicy
+{
+    using SegmentType = Segment;
+    Segment operator()(const Eigen::Vector3d &A, const Eigen::Vector3d &B) const
+    {
+        return Segment(A, B);
+    }
+};
+using SegmentMetric = MetricPolicy<LineSegment>;
+using LineMetric = MetricPolicy<InfiniteLine>;
+using HorizontalMetric = MetricPolicy<HorizontalSegment>;
+using VerticalMetric = MetricPolicy<VerticalSegment>;
+
+// separate horizontal/vertical tolerances, use with epsilon = 1.0
+struct AnisotropicMetric
+{
+    using SegmentType = AnisotropicSegment;
+    double inv_epsilon_xy2, inv_epsilon_z2;
+    // zero epsilon -> any deviation is significant
+    // infinite epsilon -> this direction is not checked
+    AnisotropicMetric(double epsilon_xy, double epsilon_z)
+        : inv_epsilon_xy2(1.0 / (epsilon_xy * epsilon_xy)),
+          inv_epsilon_z2(1.0 / (epsilon_z * epsilon_z))
+    {
+    }
+    AnisotropicSegment operator()(const Eigen::Vector3d &A,
+                                  const Eigen::Vector3d &B) const
+    {
+        return AnisotropicSegment(A, B, inv_epsilon_xy2, inv_epsilon_z2);
+    }
+};
+
+// SED of (x, y, t) rows (SedMetric) or (x, y, z, t) rows (SedMetric4)
+template <int Dims> struct SedMetricPolicy
+{
+    using SegmentType = SynchronizedSegment<Dims>;
+    using Coords = Eigen::Matrix<double, Eigen::Dynamic, Dims, Eigen::RowMajor>;
+    SegmentType operator()(const typename SegmentType::Vector &A,
+                           const typename SegmentType::Vector &B) const
+    {
+        return SegmentType(A, B);
+    }
+};
+using SedMetric = SedMetricPolicy<3>;
+using SedMetric4 = SedMetricPolicy<4>;
+// coordinates of the core are Nx3 (RowVectors), unless the metric needs
+// others (Metric::Coords, e.g. Nx4 x, y, z, t for SedMetric4)
+template <typename Metric, typename = void> struct metric_coords
+{
+    using type = RowVectors;
+};
+template <typename Metric>
+struct metric_coords<Metric, std::void_t<typename Metric::Coords>>
+{
+    using type = typename Metric::Coords;
+};
+template <typename Metric>
+using CoordsRef = Eigen::Ref<const typename metric_coords<Metric>::type>;
+
+enum class DistanceMetric
+{
+    Segment,
+    Line,
+    Horizontal,
+    Vertical,
+    Sed, // synchronized euclidean distance, time as the last column
+};
+
+inline DistanceMetric distance_metric(const std::string &name)
+{
+    if (name == "segment") {
+        return DistanceMetric::Segment;
+    } else if (name == "line") {
+        return DistanceMetric::Line;
+    } else if (name == "horizontal") {
+        return DistanceMetric::Horizontal;
+    } else if (name == "vertical") {
+        return DistanceMetric::Vertical;
+    } else if (name == "sed") {
+        return DistanceMetric::Sed;
+    }
+    throw std::invalid_argument("invalid distance metric: '" + name +
+                                "', should be one of 'segment', 'line', "
+                                "'horizontal', 'vertical', 'sed'");
+}
+
+// calls fn(policy) with the policy matching the runtime metric
+template <typename Fn>
+auto dispatch_metric(DistanceMetric metric, Fn &&fn)
+    -> decltype(fn(SegmentMetric{}))
+{
+    switch (metric) {
+    case DistanceMetric::Line:
+        return fn(LineMetric{});
+    case DistanceMetric::Horizontal:
+        return fn(HorizontalMetric{});
+    case DistanceMetric::Vertical:
+        return fn(VerticalMetric{});
+    case DistanceMetric::Sed:
+        return fn(SedMetric{});
+    default:
+        return fn(SegmentMetric{});
+    }
+}
+
+// std::allocator that reports bytes to counter->allocated(bytes) &
+// counter->freed(bytes), for the containers of the core (see RdpStats)
+template <typename T, typename Counter> struct CountingAllocator
+{
+    using value_type = T;
+    Counter *counter;
+
+    explicit CountingAllocator(Counter &counter) : counter(&counter) {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U, Counter> &other)
+        : counter(other.counter)
+    {
+    }
+    T *allocate(size_t n)
+    {
+        T *p = std::allocator<T>().allocate(n);
+        counter->allocated(n * sizeof(T));
+        return p;
+    }
+    void deallocate(T *p, size_t n)
+    {
+        counter->freed(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+    template <typename U>
+    bool operator==(const CountingAllocator<U, Counter> &other) const
+    {
+        return counter == other.counter;
+    }
+    template <typename U>
+    bool operator!=(const CountingAllocator<U, Counter> &other) const
+    {
+        return counter != other.counter;
+    }
+};
+
+// Counters of the simplification core are a template parameter too: the
+// default NoStats does nothing (the calls inline away, containers use
+// std::allocator), RdpStats counts, WithDeadline adds a deadline.
+struct NoStats
+{
+    static constexpr bool has_deadline = false;
+    bool expired() const { return false; }
+    void scan(long) {}
+    void enter() {}
+    void leave() {}
+    void queued(size_t) {}
+    void allocated(size_t) {}
+    void freed(size_t) {}
+    template <typename T> std::allocator<T> allocator() { return {}; }
+};
+
+struct RdpStats
+{
+    static constexpr bool has_deadline = false;
+    bool expired() const { return false; }
+    long distance_evaluations = 0; // distance2 calls
+    long subproblems = 0;          // spans scanned for their farthest point
+    int max_depth = 0;             // of the recursion (recursive=True)
+    long max_queue_size = 0;       // high-water mark (else)
+    long kept = 0;                 // points in the output
+    // buffers of the call: padded input, mask, queue, output
+    long bytes_allocated = 0; // total
+    long peak_bytes = 0;      // max in use at once
+    bool cancelled = false;   // the deadline expired, the output is partial
+
+    // a span is scanned, with that many distance evaluations
+    void scan(long evaluations)
+    {
+        distance_evaluations += evaluations;
+        ++subproblems;
+    }
+    // recursion into the halves of a split span
+    void enter() { max_depth = std::max(max_depth, ++depth_); }
+    void leave() { --depth_; }
+    void queued(size_t size)
+    {
+        max_queue_size = std::max<long>(max_queue_size, size);
+    }
+    void allocated(size_t bytes)
+    {
+        bytes_allocated += bytes;
+        bytes_ += bytes;
+        peak_bytes = std::max(peak_bytes, bytes_);
+    }
+    void freed(size_t bytes) { bytes_ -= bytes; }
+    template <typename T> CountingAllocator<T, RdpStats> allocator()
+    {
+        return CountingAllocator<T, RdpStats>(*this);
+    }
+
+  private:
+    int depth_ = 0;
+    long bytes_ = 0; // in use
+};
+
+// thrown if the deadline expired and the caller asked for an error instead
+// of the partial simplification
+struct Cancelled : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// set from any thread to stop a running simplification (see Deadline)
+class CancellationToken
+{
+  public:
+    void cancel() { cancelled_ = true; }
+    bool cancelled() const
+    {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<bool> cancelled_{false};
+};
+
+// A time budget and/or a cancellation token, polled by the core at every
+// subproblem and every check_interval scanned points. Once expired, no span
+// is split anymore, so the mask is a coarser but valid simplification (all
+// splits found so far are kept).
+class Deadline
+{
+  public:
+    static constexpr int check_interval = 4096; // points, power of 2
+
+    // timeout in seconds, < 0: none
+    explicit Deadline(double timeout = -1.0,
+                      const CancellationToken *token = nullptr)
+        : token_(token), has_timeout_(timeout >= 0)
+    {
+        if (has_timeout_) {
+            deadline_ = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<
+                            std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(timeout));
+        }
+    }
+    bool expired()
+    {
+        if (!expired_) {
+            expired_ = (token_ && token_->cancelled()) ||
+                       (has_timeout_ &&
+                        std::chrono::steady_clock::now() >= deadline_);
+        }
+        return expired_;
+    }
+    // whether expired() returned true, without polling
+    bool fired() const { return expired_; }
+
+  private:
+    const CancellationToken *token_;
+    bool has_timeout_;
+    std::chrono::steady_clock::time_point deadline_;
+    bool expired_ = false;
+};
+
+// stats (NoStats, RdpStats) with a deadline
+template <typename Stats> struct WithDeadline
+{
+    static constexpr bool has_deadline = true;
+    Stats &stats;
+    Deadline &deadline;
+
+    bool expired() { return deadline.expired(); }
+    void scan(long evaluations) { stats.scan(evaluations); }
+    void enter() { stats.enter(); }
+    void leave() { stats.leave(); }
+    void queued(size_t size) { stats.queued(size); }
+    void allocated(size_t bytes) { stats.allocated(bytes); }
+    void freed(size_t bytes) { stats.freed(bytes); }
+    template <typename T> auto allocator()
+    {
+        return stats.template allocator<T>();
+    }
+};
+
+// find the farthest point (to line i->j) in range (i, j)
+// returns {max_index, max_dist2}, max_index == i if j - i <= 1 (or if the
+// deadline of stats expired during the scan)
+template <typename Metric, typename Stats>
+inline std::pair<int, double>
+farthest_point(const CoordsRef<Metric> &coords, const int i, const int j,
+               const Metric &metric, Stats &stats)
+{
+    auto line = metric(coords.row(i), coords.row(j));
+    double max_dist2 = 0.0;
+    int max_index = i;
+    int mid = i + (j - i) / 2;
+    int min_pos_to_mid = j - i;
+    for (int k = i + 1; k < j; ++k) {
+        if constexpr (Stats::has_deadline) {
+            if ((k - i) % Deadline::check_interval == 0 && stats.expired()) {
+                return {i, 0.0};
+            }
+        }
+        double dist2 = line.distance2(coords.row(k));
+        if (dist2 > max_dist2) {
+            max_dist2 = dist2;
+            max_index = k;
+        } else if (dist2 == max_dist2) {
+            // a workaround to ensure we choose a pivot close to the middle of
+            // the list, reducing recursion depth, for certain degenerate inputs
+            // https://github.com/mapbox/geojson-vt/issues/104
+            int pos_to_mid = std::abs(k - mid);
+            if (pos_to_mid < min_pos_to_mid) {
+                min_pos_to_mid = pos_to_mid;
+                max_index = k;
+            }
+        }
+    }
+    return {max_index, max_dist2};
+}
+
+template <typename Metric>
+inline std::pair<int, double>
+farthest_point(const CoordsRef<Metric> &coords, const int i, const int j,
+               const Metric &metric)
+{
+    NoStats stats;
+    return farthest_point(coords, i, j, metric, stats);
+}
+
+template <typename Metric, typename Stats>
+void douglas_simplify(const CoordsRef<Metric> &coords,
+                      Eigen::VectorXi &to_keep, const int i, const int j,
+                      const double epsilon, const Metric &metric, Stats &stats)
+{
+    to_keep[i] = to_keep[j] = 1;
+    if (j - i <= 1 || stats.expired()) {
+        return;
+    }
+    stats.scan(j - i - 1);
+    auto farthest = farthest_point(coords, i, j, metric, stats);
+    int max_index = farthest.first;
+    if (farthest.second <= epsilon * epsilon) {
+        return;
+    }
+    stats.enter();
+    douglas_simplify(coords, to_keep, i, max_index, epsilon, metric, stats);
+    douglas_simplify(coords, to_keep, max_index, j, epsilon, metric, stats);
+    stats.leave();
+}
+
+template <typename Metric = SegmentMetric>
+void douglas_simplify(const CoordsRef<Metric> &coords,
+                      Eigen::VectorXi &to_keep, const int i, const int j,
+                      const double epsilon, const Metric &metric = {})
+{
+    NoStats stats;
+    douglas_simplify(coords, to_keep, i, j, epsilon, metric, stats);
+}
+
+template <typename Metric, typename Stats>
+void douglas_simplify_iter(const CoordsRef<Metric> &coords,
+                           Eigen::VectorXi &to_keep, const int i0, const int j0,
+                           const double epsilon, const Metric &metric,
+                           Stats &stats)
+{
+    using Span = std::pair<int, int>;
+    auto allocator = stats.template allocator<Span>();
+    using Queue = std::deque<Span, decltype(allocator)>;
+    std::queue<Span, Queue> q{Queue(allocator)};
+    q.push({i0, j0});
+    while (!q.empty()) {
+        int i = q.front().first;
+        int j = q.front().second;
+        q.pop();
+        to_keep[i] = to_keep[j] = 1;
+        if (j - i <= 1 || stats.expired()) {
+            continue;
+        }
+        stats.scan(j - i - 1);
+        auto farthest = farthest_point(coords, i, j, metric, stats);
+        int max_index = farthest.first;
+        if (farthest.second <= epsilon * epsilon) {
+            continue;
+        }
+        q.push({i, max_index});
+        q.push({max_index, j});
+        stats.queued(q.size());
+    }
+}
+
+template <typename Metric = SegmentMetric>
+void douglas_simplify_iter(const CoordsRef<Metric> &coords,
+                           Eigen::VectorXi &to_keep, const int i0, const int j0,
+                           const double epsilon, const Metric &metric = {})
+{
+    NoStats stats;
+    douglas_simplify_iter(coords, to_keep, i0, j0, epsilon, metric, stats);
+}
+
+template <typename Metric = SegmentMetric>
+void douglas_simplify_iter(const CoordsRef<Metric> &coords,
+                           Eigen::VectorXi &to_keep, const double epsilon,
+                           const Metric &metric = {})
+{
+    douglas_simplify_iter(coords, to_keep, 0, to_keep.size() - 1, epsilon,
+                          metric);
+}
+
+// Bounded-error approximation of douglas_simplify, without a full scan per
+// split: a span longer than approx_samples points is split at the farthest
+// of approx_samples evenly spaced points if it exceeds epsilon. Only spans
+// whose samples are all within epsilon are scanned (farthest_point): split
+// at the farthest point if it exceeds epsilon, else accepted. So every
+// dropped vertex was checked to be within epsilon of its output segment, but
+// the mask is not rdp's (splits are near-farthest, a few more points kept).
+constexpr int approx_samples = 64;
+
+template <typename Metric, typename Stats>
+void douglas_simplify_approx(const CoordsRef<Metric> &coords,
+                             Eigen::VectorXi &to_keep, const int i0,
+                             const int j0, const double epsilon,
+                             const Metric &metric, Stats &stats)
+{
+    using Span = std::pair<int, int>;
+    auto allocator = stats.template allocator<Span>();
+    std::vector<Span, decltype(allocator)> stack(allocator);
+    stack.push_back({i0, j0});
+    const double epsilon2 = epsilon * epsilon;
+    while (!stack.empty()) {
+        const int i = stack.back().first;
+        const int j = stack.back().second;
+        stack.pop_back();
+        to_keep[i] = to_keep[j] = 1;
+        if (j - i <= 1 || stats.expired()) {
+            continue;
+        }
+        int split = i;
+        long evaluations = 0;
+        const int stride = (j - i) / approx_samples;
+        if (stride > 1) {
+            auto line = metric(coords.row(i), coords.row(j));
+            double max_dist2 = epsilon2;
+            for (int k = i + stride; k < j; k += stride) {
+                double dist2 = line.distance2(coords.row(k));
+                if (dist2 > max_dist2) {
+                    max_dist2 = dist2;
+                    split = k;
+                }
+            }
+            evaluations = (j - i - 1) / stride;
+        }
+        if (split == i) {
+            evaluations += j - i - 1;
+            auto farthest = farthest_point(coords, i, j, metric, stats);
+            if (farthest.second > epsilon2) {
+                split = farthest.first;
+            }
+        }
+        stats.scan(evaluations);
+        if (split == i) {
+            continue;
+        }
+        stack.push_back({split, j});
+        stack.push_back({i, split});
+        stats.queued(stack.size());
+    }
+}
+
+template <typename Metric = SegmentMetric>
+void douglas_simplify_approx(const CoordsRef<Metric> &coords,
+                             Eigen::VectorXi &to_keep, const int i0,
+                             const int j0, const double epsilon,
+                             const Metric &metric = {})
+{
+    NoStats stats;
+    douglas_simplify_approx(coords, to_keep, i0, j0, epsilon, metric, stats);
+}
+
+template <typename Metric, typename Stats>
+Eigen::VectorXi
+douglas_simplify_approx_mask(const CoordsRef<Metric> &coords, double epsilon,
+                             const Metric &metric, Stats &stats)
+{
+    Eigen::VectorXi mask(coords.rows());
+    mask.setZero();
+    stats.allocated(mask.size() * sizeof(int));
+    douglas_simplify_approx(coords, mask, 0, mask.size() - 1, epsilon, metric,
+                            stats);
+    return mask;
+}
+
+template <typename Metric = SegmentMetric>
+Eigen::VectorXi
+douglas_simplify_approx_mask(const CoordsRef<Metric> &coords, double epsilon,
+                             const Metric &metric = {})
+{
+    NoStats stats;
+    return douglas_simplify_approx_mask(coords, epsilon, metric, stats);
+}
+
+template <typename Metric, typename Stats>
+Eigen::VectorXi douglas_simplify_mask(const CoordsRef<Metric> &coords,
+                                      double epsilon, bool recursive,
+                                      const Metric &metric, Stats &stats)
+{
+    Eigen::VectorXi mask(coords.rows());
+    mask.setZero();
+    stats.allocated(mask.size() * sizeof(int));
+    if (recursive) {
+        douglas_simplify(coords, mask, 0, mask.size() - 1, epsilon, metric,
+                         stats);
+    } else {
+        douglas_simplify_iter(coords, mask, 0, mask.size() - 1, epsilon,
+                              metric, stats);
+    }
+    return mask;
+}
+
+template <typename Metric = SegmentMetric>
+Eigen::VectorXi douglas_simplify_mask(const CoordsRef<Metric> &coords,
+                                      double epsilon, bool recursive,
+                                      const Metric &metric = {})
+{
+    NoStats stats;
+    return douglas_simplify_mask(coords, epsilon, recursive, metric, stats);
+}
+
+// vertices already set in to_keep (anchors) are kept, the recursion is split
+// at them, i.e. each span between two anchors is simplified on its own
+template <typename Metric = SegmentMetric>
+void douglas_simplify_anchored(const Eigen::Ref<const RowVectors> &coords,
+                               Eigen::VectorXi &to_keep, double epsilon,
+                               bool recursive, const Metric &metric = {})
+{
+    const int N = coords.rows();
+    if (N == 0) {
+        return;
+    }
+    for (int i = 0, j = 1; j < N; ++j) {
+        if (j < N - 1 && !to_keep[j]) {
+            continue;
+        }
+        if (recursive) {
+            douglas_simplify(coords, to_keep, i, j, epsilon, metric);
+        } else {
+            douglas_simplify_iter(coords, to_keep, i, j, epsilon, metric);
+        }
+        i = j;
+    }
+    to_keep[0] = to_keep[N - 1] = 1;
+}
+
+using Importance = Eigen::Ref<Eigen::VectorXd, 0, Eigen::InnerStride<>>;
+
+// Per-vertex importance over [i0, j0] (multi-resolution rdp): each split point
+// gets the squared distance it was split at, capped by the importance of its
+// parent span (a span is only split if its parent was), so for any epsilon
+// with epsilon^2 >= min_dist2, rdp keeps exactly the vertices with importance
+// > epsilon^2 (plus i0, j0). Spans are only split above min_dist2, other
+// inner vertices are left untouched (caller initializes them, e.g. to 0).
+// nested=false stores the raw split distances instead (geojson-vt's
+// importance, keeps a bit more detail than rdp at coarser tolerances).
+template <typename Metric = SegmentMetric>
+void douglas_importance(const Eigen::Ref<const RowVectors> &coords,
+                        Importance importance, int i0, int j0,
+                        double min_dist2, const Metric &metric = {},
+                        bool nested = true)
+{
+    struct Span
+    {
+        int i, j;
+        double max_dist2;
+    };
+    std::vector<Span> stack;
+    stack.push_back({i0, j0, std::numeric_limits<double>::infinity()});
+    while (!stack.empty()) {
+        Span span = stack.back();
+        stack.pop_back();
+        if (span.j - span.i <= 1) {
+            continue;
+        }
+        auto farthest = farthest_point(coords, span.i, span.j, metric);
+        if (farthest.second <= min_dist2) {
+            continue;
+        }
+        int k = farthest.first;
+        double dist2 = nested ? std::min(farthest.second, span.max_dist2)
+                              : farthest.second;
+        importance[k] = dist2;
+        stack.push_back({k, span.j, dist2});
+        stack.push_back({span.i, k, dist2});
+    }
+}
+
+inline Eigen::VectorXi
+douglas_simplify_mask(const Eigen::Ref<const RowVectors> &coords,
+                      double epsilon, bool recursive, DistanceMetric metric)
+{
+    return dispatch_metric(metric, [&](const auto &policy) {
+        return douglas_simplify_mask(coords, epsilon, recursive, policy);
+    });
+}
+
+// keeps a point if it deviates more than epsilon_xy horizontally or more than
+// epsilon_z vertically
+inline Eigen::VectorXi
+douglas_simplify_mask(const Eigen::Ref<const RowVectors> &coords,
+                      double epsilon_xy, double epsilon_z, bool recursive)
+{
+    if (epsilon_xy < 0 || epsilon_z < 0) {
+        throw std::invalid_argument("epsilon_xy/epsilon_z should be >= 0");
+    }
+    return douglas_simplify_mask(coords, 1.0, recursive,
+                                 AnisotropicMetric(epsilon_xy, epsilon_z));
+}
+
+inline Eigen::VectorXi
+mask2indexes(const Eigen::Ref<const Eigen::VectorXi> &mask)
+{
+    Eigen::VectorXi indexes(mask.sum());
+    for (int i = 0, j = 0, N = mask.size(); i < N; ++i) {
+        if (mask[i]) {
+            indexes[j++] = i;
+        }
+    }
+    return indexes;
+}
+
+inline Eigen::VectorXi
+douglas_simplify_indexes(const Eigen::Ref<const RowVectors> &coords,
+                         double epsilon, bool recursive,
+                         DistanceMetric metric = DistanceMetric::Segment)
+{
+    return mask2indexes(
+        douglas_simplify_mask(coords, epsilon, recursive, metric));
+}
+
+// works for Nx3 & Nx2 coords
+template <typename Derived>
+Eigen::Matrix<typename Derived::Scalar, Eigen::Dynamic,
+              Derived::ColsAtCompileTime, Eigen::RowMajor>
+select_by_mask(const Eigen::MatrixBase<Derived> &coords,
+               const Eigen::Ref<const Eigen::VectorXi> &mask)
+{
+    Eigen::Matrix<typename Derived::Scalar, Eigen::Dynamic,
+                  Derived::ColsAtCompileTime, Eigen::RowMajor>
+        ret(mask.sum(), coords.cols());
+    int N = mask.size();
+    for (int i = 0, k = 0; i < N; ++i) {
+        if (mask[i]) {
+            ret.row(k++) = coords.row(i);
+        }
+    }
+    return ret;
+}
+
+inline RowVectors
+douglas_simplify(const Eigen::Ref<const RowVectors> &coords, double epsilon,
+                 bool recursive,
+                 DistanceMetric metric = DistanceMetric::Segment)
+{
+    return select_by_mask(
+        coords, douglas_simplify_mask(coords, epsilon, recursive, metric));
+}
+
+// 2d input is padded to Nx3 with z = 0, for vertical metric y is used as the
+// "up" axis, i.e. (x, y) -> (x, 0, y). sed needs the timestamps, no 2d input
+inline RowVectors to_Nx3(const Eigen::Ref<const RowVectorsNx2> &coords,
+                         DistanceMetric metric = DistanceMetric::Segment)
+{
+    if (metric == DistanceMetric::Sed) {
+        throw std::invalid_argument("'sed' metric needs timestamps: Nx3 (x, "
+                                    "y, t) or Nx4 (x, y, z, t) coords");
+    }
+    RowVectors xyzs(coords.rows(), 3);
+    xyzs.setZero();
+    if (metric == DistanceMetric::Vertical) {
+        xyzs.col(0) = coords.col(0);
+        xyzs.col(2) = coords.col(1);
+    } else {
+        xyzs.leftCols(2) = coords;
+    }
+    return xyzs;
+}
+} // namespace fast_rdp
+
+#endif
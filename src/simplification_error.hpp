@@ -0,0 +1,298 @@
+#ifndef FAST_RDP_SIMPLIFICATION_ERROR_HPP
+#define FAST_RDP_SIMPLIFICATION_ERROR_HPP
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+
+#include <cubao/flatbush.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace fast_rdp
+{
+// Segments of a polyline in a flatbush (xy boxes), for the distance from a
+// point to the polyline: a box search of radius r (in xy, a lower bound of the
+// 3d distance) finds every segment closer than r.
+class PolylineIndex
+{
+  public:
+    explicit PolylineIndex(const Eigen::Ref<const RowVectors> &polyline)
+        : polyline_(polyline), index_(std::max<int>(polyline.rows() - 1, 1))
+    {
+        if (polyline.rows() == 0) {
+            throw std::invalid_argument("empty polyline");
+        }
+        for (int i = 0, N = polyline.rows(); i + 1 < N; ++i) {
+            index_.Add(polyline(i, 0), polyline(i, 1), polyline(i + 1, 0),
+                       polyline(i + 1, 1));
+        }
+        if (polyline.rows() > 1) {
+            index_.Finish();
+        }
+    }
+
+    int num_segments() const { return std::max<int>(polyline_.rows() - 1, 0); }
+
+    // squared distance to segment i (to the point, if a single point)
+    double distance2(const Eigen::Vector3d &P, int i) const
+    {
+        if (num_segments() == 0) {
+            return (P - polyline_.row(0).transpose()).squaredNorm();
+        }
+        return LineSegment(polyline_.row(i), polyline_.row(i + 1)).distance2(P);
+    }
+
+    // {squared distance, segment} of the closest segment, hint: a segment
+    // likely to be close (e.g. the one of the previous point). if bound2 is
+    // given and the hint is within it, the hint is returned without search.
+    // ties (e.g. at a shared vertex) go to the segment closest to the hint
+    std::pair<double, int> nearest(const Eigen::Vector3d &P, int hint,
+                                   std::vector<int> &candidates,
+                                   double bound2 = -1.0) const
+    {
+        hint = std::max(0, std::min(hint, num_segments() - 1));
+        double best2 = distance2(P, hint);
+        if (num_segments() <= 1 || best2 <= bound2) {
+            return {best2, hint};
+        }
+        int best = hint;
+        const double r = std::sqrt(best2);
+        candidates.clear();
+        index_.Search(P[0] - r, P[1] - r, P[0] + r, P[1] + r, candidates);
+        for (int i : candidates) {
+            double d2 = distance2(P, i);
+            if (d2 < best2 ||
+                (d2 == best2 && std::abs(i - hint) < std::abs(best - hint))) {
+                best2 = d2;
+                best = i;
+            }
+        }
+        return {best2, best};
+    }
+
+  private:
+    Eigen::Ref<const RowVectors> polyline_;
+    flatbush::FlatBush<double> index_;
+};
+
+// {distance, index} of the vertex of points farthest from polyline (directed
+// Hausdorff distance, vertices to segments), vertices in parallel chunks
+inline std::pair<double, int>
+directed_hausdorff(const Eigen::Ref<const RowVectors> &points,
+                   const PolylineIndex &polyline, int num_threads = 0)
+{
+    const int N = points.rows();
+    if (N == 0) {
+        throw std::invalid_argument("empty polyline");
+    }
+    // consecutive vertices share their nearest segment hint
+    const int chunk = 4096;
+    const int num_chunks = (N + chunk - 1) / chunk;
+    std::vector<std::pair<double, int>> maxima(num_chunks, {-1.0, 0});
+    parallel_for(
+        num_chunks,
+        [&](int c) {
+            std::vector<int> candidates;
+            int hint = 0;
+            auto &max = maxima[c];
+            for (int k = c * chunk, end = std::min(N, k + chunk); k < end;
+                 ++k) {
+                // closer than the max so far: can't be the farthest
+                auto nearest = polyline.nearest(points.row(k), hint,
+                                                candidates, max.first);
+                hint = nearest.second;
+                if (nearest.first > max.first) {
+                    max = {nearest.first, k};
+                }
+            }
+        },
+        num_threads);
+    auto max = *std::max_element(
+        maxima.begin(), maxima.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+    return {std::sqrt(max.first), max.second};
+}
+
+// max distance of the points of segment AB to polyline: the distance to a
+// segment is convex along AB, so an interval whose ends have the same nearest
+// segment has its max at the ends, others are split (while the nearest
+// segments of their ends could exceed max2, down to 1e-9 of AB). hint: a
+// segment likely close to A, set to the nearest segment of B
+inline double farthest_on_segment(const Eigen::Vector3d &A,
+                                  const Eigen::Vector3d &B,
+                                  const PolylineIndex &polyline, int &hint,
+                                  std::vector<int> &candidates)
+{
+    struct Sample
+    {
+        double t, d2;
+        int nearest;
+    };
+    auto at = [&](double t) -> Eigen::Vector3d { return A + t * (B - A); };
+    auto sample = [&](double t, int hint) {
+        auto nearest = polyline.nearest(at(t), hint, candidates);
+        return Sample{t, nearest.first, nearest.second};
+    };
+    Sample a = sample(0.0, hint), b = sample(1.0, a.nearest);
+    hint = b.nearest;
+    double max2 = std::max(a.d2, b.d2);
+    std::vector<std::pair<Sample, Sample>> todo{{a, b}};
+    while (!todo.empty()) {
+        std::tie(a, b) = todo.back();
+        todo.pop_back();
+        if (a.nearest == b.nearest || b.t - a.t < 1e-9) {
+            continue;
+        }
+        // upper bound: either nearest segment, at its max over [a, b]
+        double bound2 = std::min(
+            std::max(a.d2, polyline.distance2(at(b.t), a.nearest)),
+            std::max(b.d2, polyline.distance2(at(a.t), b.nearest)));
+        if (bound2 <= max2) {
+            continue;
+        }
+        Sample m = sample(0.5 * (a.t + b.t), a.nearest);
+        max2 = std::max(max2, m.d2);
+        todo.push_back({a, m});
+        todo.push_back({m, b});
+    }
+    return std::sqrt(max2);
+}
+
+// {distance, index} of the segment of points farthest from polyline (directed
+// Hausdorff distance of every point of the segments, not only the vertices),
+// segments in parallel chunks
+inline std::pair<double, int>
+directed_hausdorff_segments(const Eigen::Ref<const RowVectors> &points,
+                            const PolylineIndex &polyline, int num_threads = 0)
+{
+    const int N = points.rows() - 1; // segments
+    if (N < 1) {
+        return directed_hausdorff(points, polyline, num_threads);
+    }
+    // consecutive segments share their nearest segment hint
+    const int chunk = 1024;
+    const int num_chunks = (N + chunk - 1) / chunk;
+    std::vector<std::pair<double, int>> maxima(num_chunks, {-1.0, 0});
+    parallel_for(
+        num_chunks,
+        [&](int c) {
+            std::vector<int> candidates;
+            int hint = 0;
+            auto &max = maxima[c];
+            for (int k = c * chunk, end = std::min(N, k + chunk); k < end;
+                 ++k) {
+                double d = farthest_on_segment(points.row(k),
+                                               points.row(k + 1), polyline,
+                                               hint, candidates);
+                if (d > max.first) {
+                    max = {d, k};
+                }
+            }
+        },
+        num_threads);
+    return *std::max_element(
+        maxima.begin(), maxima.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+}
+
+// discrete Fréchet distance between the vertices of a & b, O(|a|·|b|) time,
+// O(|a| + |b|) memory. The coupling table is split into blocks, the blocks of
+// an anti-diagonal (of blocks) only depend on the previous ones and are
+// filled in parallel, each from the last row & column of its neighbors.
+inline double discrete_frechet(const Eigen::Ref<const RowVectors> &a,
+                               const Eigen::Ref<const RowVectors> &b,
+                               int num_threads = 0)
+{
+    const int N = a.rows(), M = b.rows();
+    if (N == 0 || M == 0) {
+        throw std::invalid_argument("empty polyline");
+    }
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    // square blocks, about 2 per thread along b
+    const int threads = resolve_num_threads(num_threads, M);
+    const int size = std::max(256, (M + 2 * threads - 1) / (2 * threads));
+    const int R = (N + size - 1) / size, C = (M + size - 1) / size;
+    // squared coupling values: last row computed in each column of b, last
+    // column computed in each row of a, bottom right corner of each block
+    // (by block diagonal, read by the next block on it)
+    std::vector<double> bottom(M, inf), right(N, inf), corners(R + C, inf);
+    for (int d = 0; d < R + C - 1; ++d) {
+        const int first = std::max(0, d - C + 1);
+        parallel_for(
+            std::min(d, R - 1) - first + 1,
+            [&](int k) {
+                const int I = first + k, J = d - I;
+                const int i0 = I * size, i1 = std::min(N, i0 + size);
+                const int j0 = J * size, j1 = std::min(M, j0 + size);
+                double &corner = corners[J - I + R];
+                std::vector<double> up(bottom.begin() + j0,
+                                       bottom.begin() + j1);
+                // (i - 1, j0 - 1)
+                double up_left0 = I > 0 && J > 0 ? corner : inf;
+                for (int i = i0; i < i1; ++i) {
+                    double left = J > 0 ? right[i] : inf;
+                    double up_left = up_left0;
+                    up_left0 = left;
+                    for (int j = j0; j < j1; ++j) {
+                        const double d2 = (a.row(i) - b.row(j)).squaredNorm();
+                        const double reach =
+                            i == 0 && j == 0
+                                ? d2
+                                : std::min({up[j - j0], up_left, left});
+                        up_left = up[j - j0];
+                        left = up[j - j0] = std::max(reach, d2);
+                    }
+                    right[i] = left;
+                }
+                std::copy(up.begin(), up.end(), bottom.begin() + j0);
+                corner = up.back();
+            },
+            num_threads);
+    }
+    return std::sqrt(bottom[M - 1]);
+}
+
+struct SimplificationError
+{
+    // directed Hausdorff distances: max distance of the original vertices to
+    // the simplified line, of any point of the simplified line to the
+    // original (a subset of the vertices still deviates between them)
+    double original_to_simplified, simplified_to_original;
+    int farthest_index; // vertex of original at original_to_simplified
+    double hausdorff;   // symmetric, max of both
+    double frechet = std::numeric_limits<double>::quiet_NaN(); // discrete
+};
+
+// Max deviation between a line and its simplification: directed and
+// symmetric Hausdorff distances (the segments of each line indexed in a
+// flatbush, original vertices & simplified segments queried in parallel),
+// discrete Fréchet distance if
+// frechet (anti-diagonals of blocks in parallel)
+inline SimplificationError
+simplification_error(const Eigen::Ref<const RowVectors> &original,
+                     const Eigen::Ref<const RowVectors> &simplified,
+                     bool frechet = false, int num_threads = 0)
+{
+    SimplificationError error;
+    auto forward = directed_hausdorff(original, PolylineIndex(simplified),
+                                      num_threads);
+    auto backward = directed_hausdorff_segments(
+        simplified, PolylineIndex(original), num_threads);
+    error.original_to_simplified = forward.first;
+    error.farthest_index = forward.second;
+    error.simplified_to_original = backward.first;
+    error.hausdorff = std::max(forward.first, backward.first);
+    if (frechet) {
+        error.frechet = discrete_frechet(original, simplified, num_threads);
+    }
+    return error;
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef FAST_RDP_SLEEVE_HPP
+#define FAST_RDP_SLEEVE_HPP
+
+#include "rdp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace fast_rdp
+{
+// Online simplification in one pass, O(1) time per vertex and O(1) memory
+// (Zhao & Saalfeld's sleeve fitting): from the last key vertex A, the
+// directions of a segment A->P that passes within epsilon of every vertex
+// pushed since A form a cone (per vertex Q: half-angle asin(epsilon / |AQ|)
+// around AQ). The next vertex extends the segment while it is in the cone
+// and not closer to A than the vertices it skips (so they project inside the
+// segment), else the previous vertex becomes the next key vertex. Every
+// dropped vertex is within epsilon of its output segment (LineSegment
+// distance), like rdp, but the key vertices are chosen greedily.
+//
+// The cones of 2d lines are arcs, intersected exactly. In 3d, the feasible
+// set is kept as the largest circular cone inside the intersection, which is
+// conservative (a few more vertices kept), but still O(1).
+class SleeveSimplifier
+{
+  public:
+    explicit SleeveSimplifier(double epsilon) : epsilon_(epsilon)
+    {
+        if (!(epsilon >= 0)) {
+            throw std::invalid_argument("epsilon should be >= 0");
+        }
+    }
+
+    // next vertex of the line, returns the index of the vertex it makes a
+    // key vertex (see key()), -1 if none
+    int push(const Eigen::Vector3d &P)
+    {
+        const int index = count_++;
+        if (index == 0) {
+            key_ = last_ = P;
+            key_index_ = 0;
+            return 0;
+        }
+        int emitted = -1;
+        if (!extends(P)) {
+            key_ = last_;
+            key_index_ = index - 1;
+            emitted = key_index_;
+            constrained_ = false;
+            max_radius_ = 0.0;
+        }
+        narrow(P);
+        last_ = P;
+        return emitted;
+    }
+
+    // end of the line, returns the index of the last vertex (a key vertex),
+    // -1 if it already is one (or no vertex was pushed)
+    int finish()
+    {
+        if (count_ == 0 || key_index_ == count_ - 1) {
+            return -1;
+        }
+        key_ = last_;
+        key_index_ = count_ - 1;
+        return key_index_;
+    }
+
+    const Eigen::Vector3d &key() const { return key_; } // last key vertex
+    int size() const { return count_; }                 // vertices pushed
+
+  private:
+    double epsilon_;
+    int count_ = 0;
+    Eigen::Vector3d key_ = Eigen::Vector3d::Zero();
+    Eigen::Vector3d last_ = Eigen::Vector3d::Zero();
+    int key_index_ = -1;
+    // feasible directions from key_: unit axis & half-angle, unconstrained
+    // while all vertices since key_ are within epsilon of it
+    bool constrained_ = false;
+    Eigen::Vector3d axis_ = Eigen::Vector3d::Zero();
+    double half_angle_ = 0.0;
+    double max_radius_ = 0.0; // max |key_ Q| of the vertices since key_
+
+    static double angle(const Eigen::Vector3d &u, const Eigen::Vector3d &v)
+    {
+        return std::atan2(u.cross(v).norm(), u.dot(v));
+    }
+
+    // segment key_ -> P is within epsilon of the vertices since key_
+    bool extends(const Eigen::Vector3d &P) const
+    {
+        if (!constrained_) {
+            return true;
+        }
+        Eigen::Vector3d AP = P - key_;
+        return AP.norm() >= max_radius_ && angle(axis_, AP) <= half_angle_;
+    }
+
+    // intersects the feasible cone with the cone of P
+    void narrow(const Eigen::Vector3d &P)
+    {
+        Eigen::Vector3d AP = P - key_;
+        const double r = AP.norm();
+        max_radius_ = std::max(max_radius_, r);
+        if (r <= epsilon_) {
+            return;
+        }
+        Eigen::Vector3d u = AP / r;
+        const double beta = std::asin(epsilon_ / r);
+        if (!constrained_) {
+            constrained_ = true;
+            axis_ = u;
+            half_angle_ = beta;
+            return;
+        }
+        const double delta = angle(axis_, u);
+        if (delta + half_angle_ <= beta) {
+            return; // inside P's cone
+        }
+        if (delta + beta <= half_angle_) {
+            axis_ = u; // P's cone is inside
+            half_angle_ = beta;
+            return;
+        }
+        // largest cone in the lens: centered between both edges, on the arc
+        // from axis_ to u
+        const double theta = (delta + half_angle_ - beta) / 2;
+        Eigen::Vector3d w = (u - u.dot(axis_) * axis_).normalized();
+        axis_ = std::cos(theta) * axis_ + std::sin(theta) * w;
+        half_angle_ = std::max(0.0, (half_angle_ + beta - delta) / 2);
+    }
+};
+
+inline Eigen::VectorXi
+sleeve_simplify_mask(const Eigen::Ref<const RowVectors> &coords,
+                     double epsilon)
+{
+    SleeveSimplifier sleeve(epsilon);
+    Eigen::VectorXi mask(coords.rows());
+    mask.setZero();
+    for (int i = 0, N = coords.rows(); i < N; ++i) {
+        int key = sleeve.push(coords.row(i));
+        if (key >= 0) {
+            mask[key] = 1;
+        }
+    }
+    int key = sleeve.finish();
+    if (key >= 0) {
+        mask[key] = 1;
+    }
+    return mask;
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef FAST_RDP_SQUISH_HPP
+#define FAST_RDP_SQUISH_HPP
+
+#include "parallel.hpp"
+#include "rdp.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace fast_rdp
+{
+// SQUISH-E (Muckell et al.), trajectory compression in a bounded buffer:
+// vertices (x, y, t) or (x, y, z, t) are pushed one by one, each buffered
+// vertex has a priority, an upper bound of the SED error its removal causes
+// (SED to its neighbors + the max priority of the vertices already removed
+// next to it), kept in a min-heap. The vertex of lowest priority is removed
+// while the buffer is over its capacity, or while its priority is <= max_error:
+//  - ratio: the capacity grows by one every `ratio` vertices (compression
+//    ratio, 1: no ratio bound)
+//  - max_error: SED error bound (0: only exactly redundant vertices)
+//  - capacity: hard cap of buffered vertices (fixed memory per track, 0: none)
+// error_bound() is an upper bound of the SED of every removed vertex to the
+// buffered line, <= max_error unless ratio or capacity forced removals above.
+// Tracks are independent, one SquishE per track (not thread-safe).
+template <int Dims = 3> class SquishE
+{
+  public:
+    using Vector = typename SynchronizedSegment<Dims>::Vector;
+    using Coords = Eigen::Matrix<double, Eigen::Dynamic, Dims, Eigen::RowMajor>;
+
+    explicit SquishE(double ratio = 1.0, double max_error = 0.0,
+                     int capacity = 0)
+        : ratio_(ratio), max_error_(max_error), capacity_(capacity)
+    {
+        if (!(ratio >= 1.0)) {
+            throw std::invalid_argument("ratio should be >= 1");
+        }
+        if (!(max_error >= 0)) {
+            throw std::invalid_argument("max_error should be >= 0");
+        }
+        if (capacity != 0 && capacity < 3) {
+            throw std::invalid_argument("capacity should be >= 3 (or 0)");
+        }
+    }
+
+    void push(const Vector &P)
+    {
+        const int index = count_++;
+        if (index / ratio_ >= beta_) {
+            ++beta_;
+        }
+        const int slot = allocate();
+        Node &node = nodes_[slot];
+        node.P = P;
+        node.index = index;
+        node.error = 0.0;
+        node.priority = inf;
+        node.prev = tail_;
+        node.next = -1;
+        if (tail_ >= 0) {
+            nodes_[tail_].next = slot;
+        } else {
+            head_ = slot;
+        }
+        tail_ = slot;
+        heap_push(slot);
+        if (node.prev >= 0) {
+            adjust(node.prev);
+        }
+        if (ratio_ > 1.0 && size_ >= beta_) {
+            reduce();
+        }
+        while (capacity_ > 0 && size_ > capacity_) {
+            reduce();
+        }
+        while (size_ > 2 && nodes_[heap_[0]].priority <= max_error_) {
+            reduce();
+        }
+    }
+
+    int size() const { return size_; }        // buffered vertices
+    int num_pushed() const { return count_; } // all vertices
+    double error_bound() const { return error_bound_; }
+
+    // indices (among the pushed vertices) of the buffered ones, in order
+    std::vector<int> indices() const
+    {
+        std::vector<int> ret;
+        ret.reserve(size_);
+        for (int s = head_; s >= 0; s = nodes_[s].next) {
+            ret.push_back(nodes_[s].index);
+        }
+        return ret;
+    }
+    Coords coords() const
+    {
+        Coords ret(size_, Dims);
+        int k = 0;
+        for (int s = head_; s >= 0; s = nodes_[s].next) {
+            ret.row(k++) = nodes_[s].P;
+        }
+        return ret;
+    }
+
+  private:
+    static constexpr double inf = std::numeric_limits<double>::infinity();
+    struct Node
+    {
+        Vector P;
+        int index;
+        double error;    // max priority of the removed neighbors
+        double priority; // inf for the endpoints
+        int prev, next;  // slots, -1: none
+        int heap;        // position in heap_
+    };
+
+    double ratio_, max_error_;
+    int capacity_;
+    int beta_ = 4; // current capacity (ratio), unused if ratio is 1
+    int count_ = 0, size_ = 0;
+    int head_ = -1, tail_ = -1;
+    double error_bound_ = 0.0;
+    std::vector<Node> nodes_; // slots, recycled through free_
+    std::vector<int> free_;
+    std::vector<int> heap_; // of slots, min priority first
+
+    int allocate()
+    {
+        ++size_;
+        if (!free_.empty()) {
+            int slot = free_.back();
+            free_.pop_back();
+            return slot;
+        }
+        nodes_.emplace_back();
+        return nodes_.size() - 1;
+    }
+
+    void adjust(int slot)
+    {
+        Node &node = nodes_[slot];
+        if (node.prev < 0 || node.next < 0) {
+            return;
+        }
+        SynchronizedSegment<Dims> segment(nodes_[node.prev].P,
+                                          nodes_[node.next].P);
+        node.priority = node.error + segment.distance(node.P);
+        heap_fix(node.heap);
+    }
+
+    // removes the vertex of lowest priority
+    void reduce()
+    {
+        const int slot = heap_[0];
+        const Node &node = nodes_[slot];
+        if (node.priority == inf) {
+            return; // only endpoints left
+        }
+        heap_pop();
+        error_bound_ = std::max(error_bound_, node.priority);
+        const int prev = node.prev, next = node.next;
+        nodes_[prev].next = next;
+        nodes_[next].prev = prev;
+        nodes_[prev].error = std::max(nodes_[prev].error, node.priority);
+        nodes_[next].error = std::max(nodes_[next].error, node.priority);
+        free_.push_back(slot);
+        --size_;
+        adjust(prev);
+        adjust(next);
+    }
+
+    // binary heap of slots, positions tracked in Node::heap
+    bool less(int a, int b) const
+    {
+        return nodes_[heap_[a]].priority < nodes_[heap_[b]].priority;
+    }
+    void swap(int a, int b)
+    {
+        std::swap(heap_[a], heap_[b]);
+        nodes_[heap_[a]].heap = a;
+        nodes_[heap_[b]].heap = b;
+    }
+    void heap_push(int slot)
+    {
+        nodes_[slot].heap = heap_.size();
+        heap_.push_back(slot);
+        heap_fix(heap_.size() - 1);
+    }
+    void heap_pop()
+    {
+        swap(0, heap_.size() - 1);
+        heap_.pop_back();
+        if (!heap_.empty()) {
+            heap_fix(0);
+        }
+    }
+    void heap_fix(int i)
+    {
+        while (i > 0 && less(i, (i - 1) / 2)) {
+            swap(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+        const int n = heap_.size();
+        while (true) {
+            int min = i;
+            for (int c = 2 * i + 1; c <= 2 * i + 2 && c < n; ++c) {
+                if (less(c, min)) {
+                    min = c;
+                }
+            }
+            if (min == i) {
+                return;
+            }
+            swap(i, min);
+            i = min;
+        }
+    }
+};
+
+// SQUISH-E of each track (Nx3 x, y, t or Nx4 x, y, z, t), in parallel
+template <int Dims>
+std::vector<Eigen::VectorXi> squish_masks(
+    const std::vector<typename SquishE<Dims>::Coords> &tracks, double ratio,
+    double max_error, int capacity, int num_threads = 0)
+{
+    std::vector<Eigen::VectorXi> masks(tracks.size());
+    parallel_for(
+        tracks.size(),
+        [&](int l) {
+            const auto &track = tracks[l];
+            trace::Scope scope("squish_e", "squish", l, track.rows());
+            SquishE<Dims> squish(ratio, max_error, capacity);
+            for (int i = 0, N = track.rows(); i < N; ++i) {
+                squish.push(track.row(i));
+            }
+            masks[l].setZero(track.rows());
+            for (int i : squish.indices()) {
+                masks[l][i] = 1;
+            }
+        },
+        num_threads);
+    return masks;
+}
+} // namespace fast_rdp
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef FAST_RDP_TOPOLOGY_HPP
+#define FAST_RDP_TOPOLOGY_HPP
+
+#include "rdp.hpp"
+
+#include <map> // used (not included) by cubao/kd_quiver.hpp
+#include <cubao/fast_crossing.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace fast_rdp
+{
+// polyline is a ring if first point == last point
+inline bool is_ring(const Eigen::Ref<const RowVectors> &coords)
+{
+    int N = coords.rows();
+    return N > 3 && coords.row(0) == coords.row(N - 1);
+}
+
+// segments s1 < s2 of a simplified polyline with num_segs segments share a
+// vertex (intersections there are not crossings)
+inline bool is_adjacent(int s1, int s2, int num_segs, bool ring)
+{
+    if (s1 > s2) {
+        std::swap(s1, s2);
+    }
+    return s1 == s2 || s1 + 1 == s2 ||
+           (ring && s1 == 0 && s2 == num_segs - 1);
+}
+
+// two segments only touching at their end points share a (kept) vertex of
+// the input, this is not a crossing introduced by simplification
+inline bool is_end_point_touch(const Eigen::Vector2d &ts)
+{
+    return (ts[0] == 0.0 || ts[0] == 1.0) && (ts[1] == 0.0 || ts[1] == 1.0);
+}
+
+// Refines rdp masks (in place) of several polylines (or rings) until the
+// simplified lines do not cross each other in xy-plane (and, if
+// self_intersection, do not self-intersect).
+//
+// Segments of the simplified geometry are indexed by FastCrossing (packed
+// hilbert r-tree), all crossings are found once. Each further round only
+// re-selects the lines refined by the previous round and only checks the
+// segments it created. Lines refined since the index was built are indexed
+// again in a small second index (their segments in the first one are
+// skipped), the first index is rebuilt once they hold half of its segments.
+// A crossing is resolved by splitting the spans of both segments at their
+// farthest point (by the same metric), so the epsilon bound still holds, and
+// only spans involved in a crossing are touched. Crossings between original
+// edges (input already crosses) cannot be resolved and are left as is.
+template <typename Metric = SegmentMetric>
+void preserve_topology(const std::vector<Eigen::Ref<const RowVectors>> &lines,
+                       std::vector<Eigen::VectorXi> &masks,
+                       bool self_intersection = true,
+                       const Metric &metric = {})
+{
+    const int num_lines = lines.size();
+    std::vector<char> rings(num_lines);
+    for (int l = 0; l < num_lines; ++l) {
+        rings[l] = is_ring(lines[l]);
+    }
+    std::vector<Eigen::VectorXi> indexes(num_lines);
+    std::vector<RowVectors> simplified(num_lines);
+    // per line, spans (by start index in original coords) split in the last
+    // round, allocated once the line is refined
+    std::vector<std::vector<char>> dirty(num_lines);
+    std::vector<int> refined_in(num_lines, -1); // last round, -1: never
+    std::vector<int> changed(num_lines); // lines refined in the last round
+    std::iota(changed.begin(), changed.end(), 0);
+
+    // index of all lines (as of some round) & of the lines refined since
+    std::unique_ptr<cubao::FastCrossing> indexed, refined;
+    std::vector<char> stale(num_lines, 0); // refined since `indexed`
+    std::vector<int> stale_lines;
+    int num_indexed = 0; // segments in `indexed`
+    auto add = [&](cubao::FastCrossing &fc, int l) {
+        if (simplified[l].rows() < 2) {
+            return 0;
+        }
+        fc.add_polyline(simplified[l], l);
+        return int(simplified[l].rows()) - 1;
+    };
+
+    for (int round = 0;; ++round) {
+        for (int l : changed) {
+            indexes[l] = mask2indexes(masks[l]);
+            simplified[l] = select_by_mask(lines[l], masks[l]);
+        }
+        for (int l : changed) {
+            if (round > 0 && !stale[l]) {
+                stale[l] = 1;
+                stale_lines.push_back(l);
+            }
+        }
+        int num_stale = 0;
+        for (int l : stale_lines) {
+            num_stale += simplified[l].rows() - 1;
+        }
+        if (round == 0 || 2 * num_stale > num_indexed) {
+            indexed = std::make_unique<cubao::FastCrossing>();
+            num_indexed = 0;
+            for (int l = 0; l < num_lines; ++l) {
+                num_indexed += add(*indexed, l);
+            }
+            if (num_indexed < 2) {
+                return;
+            }
+            indexed->finish();
+            for (int l : stale_lines) {
+                stale[l] = 0;
+            }
+            stale_lines.clear();
+        }
+        refined.reset();
+        if (!stale_lines.empty()) {
+            refined = std::make_unique<cubao::FastCrossing>();
+            for (int l : stale_lines) {
+                add(*refined, l);
+            }
+            refined->finish();
+        }
+
+        // (line, segment) to refine
+        std::vector<std::pair<int, int>> spans;
+        auto refine = [&](const auto &inter, int l1, int s1) {
+            const Eigen::Vector2i &label2 = std::get<3>(inter);
+            int l2 = label2[0], s2 = label2[1];
+            if (is_end_point_touch(std::get<1>(inter))) {
+                return;
+            }
+            if (l1 == l2 && (!self_intersection ||
+                             is_adjacent(s1, s2, indexes[l1].size() - 1,
+                                         rings[l1]))) {
+                return;
+            }
+            spans.emplace_back(l1, s1);
+            spans.emplace_back(l2, s2);
+        };
+        if (round == 0) {
+            for (auto &inter : indexed->intersections()) {
+                const Eigen::Vector2i &label1 = std::get<2>(inter);
+                refine(inter, label1[0], label1[1]);
+            }
+        } else {
+            for (int l : changed) {
+                const auto &xyzs = simplified[l];
+                for (int s = 0, S = indexes[l].size() - 1; s < S; ++s) {
+                    if (!dirty[l][indexes[l][s]]) {
+                        continue;
+                    }
+                    const Eigen::Vector2d p0 = xyzs.row(s).head(2);
+                    const Eigen::Vector2d p1 = xyzs.row(s + 1).head(2);
+                    for (auto &inter : indexed->intersections(p0, p1)) {
+                        if (!stale[std::get<3>(inter)[0]]) {
+                            refine(inter, l, s);
+                        }
+                    }
+                    if (refined) {
+                        for (auto &inter : refined->intersections(p0, p1)) {
+                            refine(inter, l, s);
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int l : changed) {
+            if (refined_in[l] >= 0) {
+                std::fill(dirty[l].begin(), dirty[l].end(), 0);
+            }
+        }
+        changed.clear();
+        for (auto &span : spans) {
+            int l = span.first, s = span.second;
+            int i = indexes[l][s], j = indexes[l][s + 1];
+            if (j - i <= 1 || (refined_in[l] == round && dirty[l][i])) {
+                // original edge, or already split in this round
+                continue;
+            }
+            if (refined_in[l] < 0) {
+                dirty[l].assign(lines[l].rows(), 0);
+            }
+            if (refined_in[l] != round) {
+                refined_in[l] = round;
+                changed.push_back(l);
+            }
+            int k = farthest_point(lines[l], i, j, metric).first;
+            masks[l][k] = 1;
+            dirty[l][i] = dirty[l][k] = 1;
+        }
+        if (changed.empty()) {
+            return;
+        }
+    }
+}
+
+// single polyline (or ring), refined until it does not self-intersect
+template <typename Metric = SegmentMetric>
+void preserve_topology(const Eigen::Ref<const RowVectors> &coords,
+                       Eigen::VectorXi &to_keep, const Metric &metric = {})
+{
+    std::vector<Eigen::Ref<const RowVectors>> lines{coords};
+    std::vector<Eigen::VectorXi> masks(1);
+    masks[0].swap(to_keep);
+    preserve_topology(lines, masks, true, metric);
+    masks[0].swap(to_keep);
+}
+
+template <typename Metric = SegmentMetric>
+Eigen::VectorXi
+douglas_simplify_topology_mask(const Eigen::Ref<const RowVectors> &coords,
+                               double epsilon, bool recursive,
+                               const Metric &metric = {})
+{
+    Eigen::VectorXi mask =
+        douglas_simplify_mask(coords, epsilon, recursive, metric);
+    preserve_topology(coords, mask, metric);
+    return mask;
+}
+} // namespace fast_rdp
+
+#endif
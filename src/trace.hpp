@@ -0,0 +1,175 @@
+#ifndef FAST_RDP_TRACE_HPP
+#define FAST_RDP_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fast_rdp
+{
+// Opt-in tracer of parallel tasks (one event per line/feature: begin, end,
+// line id, N, engine, thread), dumped as Chrome trace-event JSON (open in
+// https://ui.perfetto.dev or chrome://tracing). Each thread appends to its
+// own buffer, without locks; a mutex is only taken once per thread, to
+// register its buffer. Disabled, a task costs one relaxed atomic load.
+//
+// start() / stop() / dump() must not run concurrently with traced calls.
+namespace trace
+{
+struct Event
+{
+    const char *name; // engine, static string
+    const char *category;
+    int64_t id, n; // line/feature id, #points (-1: unknown)
+    int64_t begin, end; // ns since start()
+};
+
+struct Buffer
+{
+    int tid;
+    std::atomic<bool> alive{true}; // its thread hasn't exited
+    std::vector<Event> events;
+};
+
+struct State
+{
+    std::atomic<bool> enabled{false};
+    std::chrono::steady_clock::time_point origin;
+    std::mutex mutex; // buffers
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    int next_tid = 1;
+};
+
+inline State &state()
+{
+    static State state;
+    return state;
+}
+
+inline bool enabled()
+{
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+inline int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - state().origin)
+        .count();
+}
+
+// buffer of the calling thread, registered on first use, kept (for dump)
+// after the thread exits
+inline Buffer &buffer()
+{
+    struct Owner
+    {
+        std::shared_ptr<Buffer> buffer;
+        Owner() : buffer(std::make_shared<Buffer>())
+        {
+            auto &s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            buffer->tid = s.next_tid++;
+            s.buffers.push_back(buffer);
+        }
+        ~Owner() { buffer->alive = false; }
+    };
+    thread_local Owner owner;
+    return *owner.buffer;
+}
+
+// clears the events (and buffers of exited threads), starts recording
+inline void start()
+{
+    auto &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<std::shared_ptr<Buffer>> alive;
+    for (auto &b : s.buffers) {
+        if (b->alive) {
+            b->events.clear();
+            alive.push_back(b);
+        }
+    }
+    s.buffers.swap(alive);
+    s.origin = std::chrono::steady_clock::now();
+    s.enabled = true;
+}
+
+inline void stop() { state().enabled = false; }
+
+// one task, recorded from construction to destruction if tracing
+class Scope
+{
+  public:
+    Scope(const char *name, const char *category, int64_t id, int64_t n = -1)
+    {
+        if (enabled()) {
+            event_ = {name, category, id, n, now(), 0};
+            active_ = true;
+        }
+    }
+    ~Scope()
+    {
+        if (active_) {
+            event_.end = now();
+            buffer().events.push_back(event_);
+        }
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Event event_;
+    bool active_ = false;
+};
+
+// Chrome trace-event JSON of the recorded events (complete "X" events, one
+// track per thread), returns the number of events
+inline int64_t dump(std::ostream &out)
+{
+    auto &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    int64_t count = 0;
+    out << R"({"displayTimeUnit":"ns","traceEvents":[)"
+        << R"({"name":"process_name","ph":"M","pid":1,"tid":0,)"
+        << R"("args":{"name":"fast_rdp"}})";
+    char ts[64];
+    for (const auto &b : s.buffers) {
+        for (const auto &e : b->events) {
+            // microseconds, with ns precision
+            std::snprintf(ts, sizeof(ts), R"("ts":%.3f,"dur":%.3f)",
+                          e.begin / 1e3, (e.end - e.begin) / 1e3);
+            out << R"(,{"name":")" << e.name << R"(","cat":")" << e.category
+                << R"(","ph":"X",)" << ts << R"(,"pid":1,"tid":)" << b->tid
+                << R"(,"args":{"id":)" << e.id;
+            if (e.n >= 0) {
+                out << R"(,"N":)" << e.n;
+            }
+            out << "}}";
+            ++count;
+        }
+    }
+    out << "]}\n";
+    return count;
+}
+
+inline int64_t dump(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("failed to open " + path);
+    }
+    return dump(out);
+}
+} // namespace trace
+} // namespace fast_rdp
+
+#endif
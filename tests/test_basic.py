@@ -1,11 +1,47 @@
+import json
 import os
+import struct
 import sys
 import time
+from concurrent.futures import ThreadPoolExecutor
 
 import numpy as np
 import pytest
 
-from fast_rdp import LineSegment, rdp
+from fast_rdp import (
+    CancellationToken,
+    Cancelled,
+    DeadReckoning,
+    GeoJSONVT,
+    LineSegment,
+    MultiResolutionIndex,
+    RdpStats,
+    SleeveSimplifier,
+    SquishE,
+    build_multires_index,
+    dead_reckoning,
+    dead_reckoning_mask,
+    decode_polylines,
+    encode_mvt,
+    encode_polyline,
+    encode_polylines,
+    has_zlib,
+    rdp,
+    rdp_batch,
+    rdp_batch_mask,
+    rdp_mask,
+    rdp_network,
+    read_flatgeobuf,
+    simplification_error,
+    simplify_flatgeobuf,
+    simplify_geojson,
+    sleeve,
+    sleeve_mask,
+    squish,
+    squish_mask,
+    trace,
+    write_flatgeobuf,
+)
 
 
 def test_segment():
@@ -25,6 +61,964 @@ def test_rdp():
     assert rdp([[0, 0], [5, 1 - 1e-3], [10, 0]], epsilon=1).shape == (2, 2)
 
 
+def test_rdp_stats():
+    coords = np.array([[0, 0], [1, 1], [2, 3], [3, 1], [4, 0]], dtype=np.float64)
+    # splits at 2, then at 1 & 3
+    ret, stats = rdp(coords, epsilon=0.1, algo="recursive", return_stats=True)
+    assert isinstance(stats, RdpStats)
+    assert len(ret) == stats.kept == 5
+    assert stats.subproblems == 3
+    assert stats.distance_evaluations == 3 + 1 + 1
+    assert stats.max_depth == 2 and stats.max_queue_size == 0
+
+    mask, stats = rdp(coords, 0.1, return_mask=True, return_stats=True)
+    assert mask.sum() == stats.kept == 5
+    assert stats.subproblems == 3 and stats.max_depth == 0
+    assert stats.max_queue_size == 4
+
+    ret, stats = rdp(coords, epsilon=10, return_stats=True)
+    assert len(ret) == stats.kept == 2
+    assert stats.subproblems == 1 and stats.distance_evaluations == 3
+    assert "kept=2" in repr(stats)
+    assert rdp(coords, epsilon=10).shape == (2, 2)
+
+    # memory: Nx3 pad of the Nx2 input, freed before the output is allocated
+    N = 1000
+    line = np.random.default_rng(0).random((N, 2))
+    _, stats = rdp(line, 0.1, algo="recursive", return_stats=True)
+    pad, mask, out = N * 3 * 8, N * 4, stats.kept * 2 * 8
+    assert stats.bytes_allocated == pad + mask + out
+    assert stats.peak_bytes == max(pad, out) + mask
+    _, stats = rdp(line, 0.1, return_mask=True, return_stats=True)
+    assert stats.bytes_allocated > pad + mask  # + the queue
+    assert pad + mask < stats.peak_bytes < stats.bytes_allocated
+
+
+def test_approximate():
+    def max_deviation(line, mask):
+        # of dropped points, to their output segment
+        kept = np.flatnonzero(mask)
+        ret = 0.0
+        for i, j in zip(kept[:-1], kept[1:]):
+            seg = LineSegment(line[i], line[j])
+            for k in range(i + 1, j):
+                ret = max(ret, seg.distance(line[k]))
+        return ret
+
+    rng = np.random.default_rng(0)
+    for N in (2, 10, 128, 5000):
+        line = rng.random((N, 3)).cumsum(axis=0)
+        for epsilon in (0.5, 2.0, 10.0):
+            exact = rdp(line, epsilon, return_mask=True)
+            mask, stats = rdp(
+                line, epsilon, algo="approx", return_mask=True, return_stats=True
+            )
+            assert mask[0] == mask[-1] == 1
+            assert max_deviation(line, mask) <= epsilon
+            assert stats.kept == mask.sum()
+            if N <= 128:  # no sampling, same as rdp
+                np.testing.assert_array_equal(mask, exact)
+            else:
+                assert stats.distance_evaluations < rdp(
+                    line, epsilon, return_stats=True
+                )[1].distance_evaluations
+    xys = rng.random((1000, 2)).cumsum(axis=0)
+    assert rdp(xys, 1.0, algo="approx").shape[1] == 2
+
+
+def test_sed():
+    def sed(a, b, p):
+        dt = b[-1] - a[-1]
+        t = (p[-1] - a[-1]) / dt if dt > 0 else 0.0
+        return np.linalg.norm((a + t * (b - a) - p)[:-1])
+
+    def sed_rdp(traj, epsilon):
+        # TD-TR reference, first farthest point
+        def rec(i, j):
+            dmax, index = 0.0, i
+            for k in range(i + 1, j):
+                d = sed(traj[i], traj[j], traj[k])
+                if d > dmax:
+                    dmax, index = d, k
+            if dmax <= epsilon:
+                return [i, j]
+            return rec(i, index)[:-1] + rec(index, j)
+
+        mask = np.zeros(len(traj), dtype=np.int32)
+        mask[rec(0, len(traj) - 1)] = 1
+        return mask
+
+    # same path, a stop in the middle: kept by sed, dropped by segment
+    xyt = np.array([[0, 0, 0], [5, 0, 1], [5, 0, 9], [10, 0, 10]], float)
+    np.testing.assert_array_equal(rdp(xyt[:, :2], 1.0), xyt[[0, -1], :2])
+    np.testing.assert_array_equal(rdp(xyt, 1.0, dist="sed"), xyt[[0, 1, 2, 3]])
+
+    rng = np.random.default_rng(0)
+    for dims in (2, 3):
+        traj = rng.normal(size=(300, dims + 1)).cumsum(axis=0)
+        traj[:, -1] = np.arange(300) + rng.random(300)
+        for epsilon in (0.5, 2.0, 5.0):
+            mask = rdp(traj, epsilon, dist="sed", algo="rec", return_mask=True)
+            np.testing.assert_array_equal(mask, sed_rdp(traj, epsilon))
+            np.testing.assert_array_equal(
+                mask, rdp(traj, epsilon, dist="sed", return_mask=True)
+            )
+            approx = rdp(traj, epsilon, dist="sed", algo="approx", return_mask=True)
+            kept = np.flatnonzero(approx)
+            for i, j in zip(kept[:-1], kept[1:]):
+                for k in range(i + 1, j):
+                    assert sed(traj[i], traj[j], traj[k]) <= epsilon
+    with pytest.raises(ValueError, match="timestamps"):
+        rdp(traj[:, :2], 1.0, dist="sed")
+    with pytest.raises(ValueError, match="sed"):
+        rdp(rng.random((10, 4)), 1.0)
+
+
+def test_sleeve():
+    def max_deviation(line, mask):
+        kept = np.flatnonzero(mask)
+        ret = 0.0
+        for i, j in zip(kept[:-1], kept[1:]):
+            seg = LineSegment(line[i], line[j])
+            for k in range(i + 1, j):
+                ret = max(ret, seg.distance(line[k]))
+        return ret
+
+    np.testing.assert_array_equal(
+        sleeve([[0, 0], [1, 0.1], [2, 0], [3, 2], [4, 4]], epsilon=0.5),
+        [[0, 0], [2, 0], [4, 4]],
+    )
+    rng = np.random.default_rng(0)
+    for dims in (2, 3):
+        line = rng.normal(size=(2000, dims)).cumsum(axis=0)
+        for epsilon in (0.0, 0.5, 2.0, 10.0):
+            mask = sleeve_mask(line, epsilon=epsilon)
+            assert mask[0] == mask[-1] == 1
+            xyz = line if dims == 3 else np.c_[line, np.zeros(len(line))]
+            assert max_deviation(xyz, mask) <= epsilon + 1e-9
+            np.testing.assert_array_equal(
+                sleeve(line, epsilon=epsilon), line[mask.astype(bool)]
+            )
+            # greedy, comparable size
+            assert mask.sum() < 2 * rdp_mask(line, epsilon=epsilon).sum() + 2
+
+            # push-based, same key vertices
+            online = SleeveSimplifier(epsilon=epsilon)
+            keys = [online.push(p) for p in line] + [online.finish()]
+            np.testing.assert_array_equal(
+                [k for k in keys if k >= 0], np.flatnonzero(mask)
+            )
+            assert len(online) == len(line)
+    assert len(sleeve(np.zeros((1, 3)), epsilon=1.0)) == 1
+    with pytest.raises(ValueError):
+        SleeveSimplifier(epsilon=-1.0)
+
+
+def test_squish():
+    def max_sed(track, mask):
+        kept = np.flatnonzero(mask)
+        ret = 0.0
+        for i, j in zip(kept[:-1], kept[1:]):
+            a, b = track[i], track[j]
+            for p in track[i + 1 : j]:
+                t = (p[-1] - a[-1]) / (b[-1] - a[-1])
+                ret = max(ret, np.linalg.norm((a + t * (b - a) - p)[:-1]))
+        return ret
+
+    rng = np.random.default_rng(0)
+    tracks = []
+    for N, dims in ((1000, 2), (10, 2), (2, 2), (500, 3)):
+        track = rng.normal(size=(N, dims + 1)).cumsum(axis=0)
+        track[:, -1] = np.arange(N) + rng.random(N)
+        tracks.append(track)
+    xyts = tracks[:3]
+
+    # error bound
+    masks = squish_mask(xyts, max_error=2.0)
+    for track, mask in zip(xyts, masks):
+        assert mask[0] == mask[-1] == 1
+        assert max_sed(track, mask) <= 2.0
+    assert max_sed(tracks[3], squish_mask([tracks[3]], max_error=2.0)[0]) <= 2.0
+    # no ratio bound by default (ratio=1), nothing forced above max_error
+    for seed in range(200):
+        rng_ = np.random.default_rng(seed)
+        track = rng_.normal(size=(50, 3)).cumsum(axis=0)
+        track[:, -1] = np.arange(50) + rng_.random(50)
+        for max_error in (0.5, 1.0):
+            mask = squish_mask([track], max_error=max_error)[0]
+            assert max_sed(track, mask) <= max_error
+
+    # compression ratio & fixed capacity
+    mask = squish_mask(xyts[:1], ratio=10.0)[0]
+    assert 90 <= mask.sum() <= 110
+    mask = squish_mask(xyts[:1], capacity=32)[0]
+    assert mask.sum() == 32 and mask[0] == mask[-1] == 1
+
+    # push-based, same output
+    online = SquishE(ratio=5.0, max_error=1.0, capacity=64)
+    for p in xyts[0]:
+        online.push(p)
+        assert len(online) <= 64
+    expected = squish(xyts[:1], ratio=5.0, max_error=1.0, capacity=64)[0]
+    np.testing.assert_array_equal(online.coords(), expected)
+    np.testing.assert_array_equal(xyts[0][online.indices()], expected)
+    assert online.num_pushed == 1000
+    assert max_sed(xyts[0], np.isin(np.arange(1000), online.indices())) <= (
+        online.error_bound + 1e-9
+    )
+    with pytest.raises(ValueError):
+        SquishE(ratio=0.5)
+
+
+def test_dead_reckoning():
+    def reference(track, epsilon):
+        # kept vertex: its position & the velocity it was reached at
+        mask = np.zeros(len(track), dtype=np.int32)
+        key, v = None, None
+        for i, p in enumerate(track):
+            if key is not None:
+                pred = key[:-1] + v * (p[-1] - key[-1])
+                if np.linalg.norm(p[:-1] - pred) <= epsilon:
+                    continue
+            mask[i] = 1
+            key, v = p, np.zeros(len(p) - 1)
+            if i > 0:
+                v = (p - track[i - 1])[:-1] / (p[-1] - track[i - 1][-1])
+        mask[-1:] = 1
+        return mask
+
+    rng = np.random.default_rng(0)
+    tracks = []
+    for N in (3000, 1, 2, 50):
+        # mostly straight at constant speed, 10 Hz
+        track = np.zeros((N, 3))
+        track[:, :2] = (rng.normal(size=(N, 2)) * 0.05 + [1.0, 0.5]).cumsum(axis=0)
+        track[N // 2 :, 1] -= np.arange(N - N // 2) * 0.3  # a turn
+        track[:, 2] = np.arange(N) * 0.1
+        tracks.append(track)
+    for epsilon in (0.0, 0.2, 1.0):
+        masks = dead_reckoning_mask(tracks, epsilon=epsilon)
+        for track, mask in zip(tracks, masks):
+            np.testing.assert_array_equal(mask, reference(track, epsilon))
+            assert mask[0] == mask[-1] == 1
+        online = DeadReckoning(epsilon=epsilon)
+        kept = [online.push(p) for p in tracks[0]]
+        kept[-1] |= online.finish()
+        np.testing.assert_array_equal(kept, masks[0])
+        assert len(online) == len(tracks[0])
+        assert not online.finish()
+        np.testing.assert_array_equal(online.key, tracks[0][-1])
+
+        # the output & its velocities predict every dropped vertex
+        outputs, velocities = dead_reckoning(
+            tracks, epsilon=epsilon, return_velocities=True
+        )
+        for track, mask, out, vs in zip(tracks, masks, outputs, velocities):
+            np.testing.assert_array_equal(out, track[mask.astype(bool)])
+            assert vs.shape == (len(out), 2)
+            keys = np.cumsum(mask) - 1  # last kept vertex of each vertex
+            pred = out[keys, :-1] + vs[keys] * (track[:, -1] - out[keys, -1])[:, None]
+            assert np.linalg.norm(pred - track[:, :-1], axis=1).max() <= epsilon
+        np.testing.assert_array_equal(online.velocity, velocities[0][-1])
+    assert masks[0].sum() < 0.2 * len(tracks[0])
+    np.testing.assert_array_equal(
+        dead_reckoning(tracks, epsilon=1.0, num_threads=2)[0],
+        tracks[0][masks[0].astype(bool)],
+    )
+    xyzt = np.c_[tracks[0][:, :2], np.zeros(3000), tracks[0][:, 2]]
+    np.testing.assert_array_equal(dead_reckoning_mask([xyzt], epsilon=1.0)[0], masks[0])
+
+
+def test_integer():
+    rng = np.random.default_rng(0)
+    for N in (2, 3, 100, 5000):
+        xys = rng.integers(-200, 200, size=(N, 2)).cumsum(axis=0)
+        for epsilon in (0.0, 1.0, 3.0, 10.0, 100.0):
+            expected = rdp(xys.astype(np.float64), epsilon, return_mask=True)
+            for dtype in (np.int32, np.int16):
+                if dtype == np.int16 and np.abs(xys).max() > 32767:
+                    continue
+                coords = xys.astype(dtype)
+                np.testing.assert_array_equal(
+                    rdp(coords, epsilon, return_mask=True), expected
+                )
+                ret = rdp(coords, epsilon)
+                assert ret.dtype == dtype
+                np.testing.assert_array_equal(ret, coords[expected.astype(bool)])
+    # non-integer epsilon: compared to epsilon^2 exactly, not floor(epsilon^2)
+    line = np.array([[0, 0], [1, 1], [3, 1]], dtype=np.int32)
+    assert rdp_mask(line, epsilon=0.7).tolist() == [1, 0, 1]
+    for _ in range(200):
+        # wide steps: no exact ties, that float64 would break by rounding
+        xys = rng.integers(-100, 101, size=(rng.integers(3, 300), 2)).cumsum(axis=0)
+        for epsilon in (0.3, 0.7, 1.5, 2.5, 3.3):
+            np.testing.assert_array_equal(
+                rdp_mask(xys.astype(np.int32), epsilon=epsilon),
+                rdp_mask(xys.astype(np.float64), epsilon=epsilon),
+            )
+    # exact where float64 rounds: collinear far from the origin
+    big = 2**30 - 1
+    line = np.array([[-big, -big], [0, 1], [big, big]], dtype=np.int32)
+    assert rdp_mask(line, epsilon=0.5).tolist() == [1, 1, 1]
+    assert rdp_mask(line, epsilon=1.0).tolist() == [1, 0, 1]
+
+    mask, stats = rdp(xys.astype(np.int32), 10.0, return_mask=True, return_stats=True)
+    assert stats.kept == mask.sum() and stats.distance_evaluations > 0
+    # options the integer engine lacks: simplified as float64
+    xys = xys[:100]
+    for kwargs in (
+        dict(dist="line"),  # also what rdp.pldist maps to
+        dict(algo="approx"),
+        dict(preserve_topology=True),
+        dict(epsilon_xy=2.0),
+        dict(epsilon_z=2.0),
+    ):
+        for dtype in (np.int32, np.int16):
+            ret = rdp(xys.astype(dtype), 3.0, **kwargs)
+            assert ret.dtype == np.float64
+            expected = rdp(xys.astype(np.float64), 3.0, **kwargs)
+            np.testing.assert_array_equal(ret, expected)
+            np.testing.assert_array_equal(
+                rdp(xys.astype(dtype), 3.0, return_mask=True, **kwargs),
+                rdp(xys.astype(np.float64), 3.0, return_mask=True, **kwargs),
+            )
+    line = np.array([[0, 0], [2**30, 0], [2**31 - 1, 1]], dtype=np.int32)
+    assert rdp_mask(line, epsilon=1.0).tolist() == [1, 0, 1]
+    assert rdp(line, 1.0).dtype == np.float64
+    # lists are float64 input, whatever numpy's default int is
+    assert rdp(xys.tolist(), 3.0).dtype == np.float64
+
+
+def test_simplification_error():
+    def directed(a, b):
+        segs = [LineSegment(b[i], b[i + 1]) for i in range(len(b) - 1)]
+        return max(min(s.distance(p) for s in segs) for p in a)
+
+    def frechet(a, b):
+        ca = np.full((len(a), len(b)), np.inf)
+        dists = np.linalg.norm(a[:, None] - b[None], axis=2).tolist()
+        for i in range(len(a)):
+            for j in range(len(b)):
+                d = dists[i][j]
+                if i == 0 and j == 0:
+                    ca[i, j] = d
+                    continue
+                prev = min(
+                    ca[i - 1, j] if i else np.inf,
+                    ca[i, j - 1] if j else np.inf,
+                    ca[i - 1, j - 1] if i and j else np.inf,
+                )
+                ca[i, j] = max(prev, d)
+        return ca[-1, -1]
+
+    rng = np.random.default_rng(0)
+    line = rng.random((300, 3)).cumsum(axis=0)
+    simplified = rdp(line, 2.0)
+    error = simplification_error(line, simplified, frechet=True, num_threads=4)
+    assert error.original_to_simplified <= 2.0
+    np.testing.assert_allclose(
+        error.original_to_simplified, directed(line, simplified)
+    )
+    # simplified to original: every point of the simplified segments, the
+    # vertices alone are on the original (0)
+    assert directed(simplified, line) < 1e-9
+    t = np.linspace(0, 1, 201)[:, None]
+    samples = [a + t * (b - a) for a, b in zip(simplified[:-1], simplified[1:])]
+    sampled = directed(np.concatenate(samples), line)
+    step = np.linalg.norm(np.diff(simplified, axis=0), axis=1).max() / 200
+    assert sampled - 1e-9 <= error.simplified_to_original <= sampled + step
+    corner = simplification_error([[0, 0], [1, 1], [2, 0]], [[0, 0], [2, 0]])
+    np.testing.assert_allclose(corner.simplified_to_original, 0.5**0.5)
+    assert corner.original_to_simplified == 1.0
+    assert error.hausdorff == max(
+        error.original_to_simplified, error.simplified_to_original
+    )
+    k = error.farthest_index
+    np.testing.assert_allclose(
+        error.original_to_simplified, directed(line[[k]], simplified)
+    )
+    np.testing.assert_allclose(error.frechet, frechet(line, simplified))
+    assert np.isnan(simplification_error(line, simplified).frechet)
+    # several blocks of the coupling table (filled by anti-diagonals)
+    a, b = line[:, :2] * 1.1, rng.random((600, 2)).cumsum(axis=0)
+    expected = frechet(np.c_[a, np.zeros(len(a))], np.c_[b, np.zeros(len(b))])
+    for num_threads in (1, 4):
+        error = simplification_error(a, b, frechet=True, num_threads=num_threads)
+        np.testing.assert_allclose(error.frechet, expected)
+
+    # 2d, unrelated lines, more than one chunk of vertices
+    a = rng.random((5000, 2)).cumsum(axis=0)
+    b = rng.random((20, 2)) * 100
+    error = simplification_error(a, b)
+    np.testing.assert_allclose(
+        error.original_to_simplified,
+        directed(np.c_[a, np.zeros(len(a))], np.c_[b, np.zeros(len(b))]),
+    )
+    assert simplification_error(a, a).hausdorff == 0.0
+
+
+def test_timeout():
+    line = np.random.default_rng(0).random((10000, 3)).cumsum(axis=0)
+    expected = rdp(line, 1.0)
+    for algo in ("iter", "rec"):
+        ret = rdp(line, 1.0, algo=algo, timeout=60)
+        np.testing.assert_array_equal(ret, expected)
+        # expired before the first split: endpoints only
+        ret, stats = rdp(line, 1.0, algo=algo, timeout=0, return_stats=True)
+        assert ret.tolist() == line[[0, -1]].tolist()
+        assert stats.cancelled and stats.kept == 2
+        with pytest.raises(Cancelled):
+            rdp(line, 1.0, algo=algo, timeout=0, on_timeout="raise")
+
+    token = CancellationToken()
+    assert not token.cancelled
+    mask = rdp(line, 1.0, return_mask=True, cancel=token)
+    assert mask.sum() == len(expected)
+    token.cancel()
+    mask = rdp(line, 1.0, return_mask=True, cancel=token)
+    assert mask.tolist() == [1] + [0] * (len(line) - 2) + [1]
+    with pytest.raises(TimeoutError):
+        rdp(line, 1.0, cancel=token, on_timeout="raise")
+    with pytest.raises(ValueError):
+        rdp(line, 1.0, on_timeout="ignore")
+
+
+def test_metrics():
+    coords = [[0, 0], [12, 3], [10, 0]]
+    assert rdp(coords, 3.2).shape == (3, 2)  # segment, sqrt(13) to B
+    assert rdp(coords, 3.2, dist="line").shape == (2, 2)  # 3.0 to line
+
+    def pldist(point, start, end):
+        return np.linalg.norm(np.cross(end - start, start - point)) / np.linalg.norm(
+            end - start
+        )
+
+    assert rdp(coords, 3.2, dist=pldist).shape == (2, 2)
+
+    # horizontal ignores z, vertical only measures z
+    coords = [[0, 0, 0], [5, 0, 1], [10, 0, 0]]
+    assert rdp(coords, 0.5, dist="horizontal").shape == (2, 3)
+    assert rdp(coords, 0.5, dist="vertical").shape == (3, 3)
+    coords = [[0, 0, 0], [5, 1, 0], [10, 0, 0]]
+    assert rdp(coords, 0.5, dist="horizontal").shape == (3, 3)
+    assert rdp(coords, 0.5, dist="vertical").shape == (2, 3)
+    # for 2d input, vertical is |dy| at x
+    assert rdp([[0, 0], [5, 1], [10, 0]], 0.9, dist="vertical").shape == (3, 2)
+    assert rdp([[0, 0], [5, 1], [10, 0]], 1.1, dist="vertical").shape == (2, 2)
+
+    with pytest.raises(ValueError):
+        rdp(coords, dist="unknown")
+
+
+def test_anisotropic_epsilon():
+    # 0.3 horizontal, 0.2 vertical deviation
+    coords = [[0, 0, 0], [5, 0.3, 0.2], [10, 0, 0]]
+    assert rdp(coords, epsilon_xy=0.5, epsilon_z=0.1).shape == (3, 3)
+    assert rdp(coords, epsilon_xy=0.5, epsilon_z=0.3).shape == (2, 3)
+    assert rdp(coords, epsilon_xy=0.2, epsilon_z=0.3).shape == (3, 3)
+    # unset bound is not checked
+    assert rdp(coords, epsilon_xy=0.5).shape == (2, 3)
+    assert rdp(coords, epsilon_z=0.1).shape == (3, 3)
+    # not the same as a single epsilon on rescaled z
+    coords = np.array([[0, 0, 0], [5, 0.4, 0.08], [10, 0, 0]])
+    assert rdp(coords, epsilon_xy=0.5, epsilon_z=0.1).shape == (2, 3)
+    assert rdp(coords * [1, 1, 5], epsilon=0.5).shape == (3, 3)
+    mask = rdp(coords, return_mask=True, epsilon_xy=0.5, epsilon_z=0.1)
+    assert mask.tolist() == [1, 0, 1]
+    with pytest.raises(ValueError):
+        rdp(coords, dist="line", epsilon_xy=0.5)
+
+
+def _orient(p, q, r):
+    return np.sign((q[0] - p[0]) * (r[1] - p[1]) - (q[1] - p[1]) * (r[0] - p[0]))
+
+
+def _cross(a, b, c, d):
+    return (
+        _orient(a, b, c) * _orient(a, b, d) < 0
+        and _orient(c, d, a) * _orient(c, d, b) < 0
+    )
+
+
+def _num_crossings(polyline, other=None):
+    if other is not None:
+        return sum(
+            _cross(polyline[i], polyline[i + 1], other[j], other[j + 1])
+            for i in range(len(polyline) - 1)
+            for j in range(len(other) - 1)
+        )
+    N = len(polyline) - 1
+    count = 0
+    for i in range(N):
+        for j in range(i + 2, N):
+            count += _cross(polyline[i], polyline[i + 1], polyline[j], polyline[j + 1])
+    return count
+
+
+def test_preserve_topology():
+    rng = np.random.default_rng(0)
+    crossings = 0
+    for _ in range(10):
+        theta = np.sort(rng.uniform(0, 6 * np.pi, 200))
+        r = 1 + theta * 0.5 + rng.uniform(0, 0.3, 200)
+        spiral = np.c_[r * np.cos(theta), r * np.sin(theta)]
+        assert _num_crossings(spiral) == 0
+        for eps in (1, 2, 4):
+            crossings += _num_crossings(rdp(spiral, eps))
+            ret = rdp(spiral, eps, preserve_topology=True)
+            assert _num_crossings(ret) == 0
+            mask = rdp(spiral, eps, return_mask=True)
+            mask2 = rdp(spiral, eps, return_mask=True, preserve_topology=True)
+            assert np.all(mask2 >= mask)
+    assert crossings > 0
+
+    # ring, first & last segments are adjacent
+    ring = [[0, 0], [1, 0], [1, 1], [0, 1], [0, 0]]
+    assert len(rdp(ring, preserve_topology=True)) == 5
+
+
+def test_rdp_network():
+    # (5, 0.1) is a junction of line1 & line2, rdp alone would drop it
+    line1 = [[0, 0], [5, 0.1], [10, 0]]
+    line2 = [[5, 0.1], [5, 5], [5, 10]]
+    line3 = [[20, 0], [25, 0.1], [30, 0]]
+    assert rdp(line1, 1.0).shape == (2, 2)
+    ret = rdp_network([line1, line2, line3], 1.0)
+    assert len(ret) == 3
+    assert ret[0].tolist() == line1
+    assert ret[1].tolist() == [[5, 0.1], [5, 10]]
+    assert ret[2].tolist() == [[20, 0], [30, 0]]
+    masks = rdp_network([line1, line2, line3], 1.0, return_mask=True)
+    assert [m.tolist() for m in masks] == [[1, 1, 1], [1, 0, 1], [1, 0, 1]]
+
+    # same as rdp for unconnected lines, 3d, many threads
+    rng = np.random.default_rng(0)
+    lines = [rng.random((n, 3)).cumsum(axis=0) for n in range(1, 100)]
+    for algo in ("iter", "rec"):
+        ret = rdp_network(lines, 0.5, algo=algo, num_threads=4)
+        for line, simplified in zip(lines, ret):
+            np.testing.assert_array_equal(simplified, rdp(line, 0.5, algo=algo))
+
+
+def test_trace(tmp_path):
+    lines = [np.random.default_rng(i).random((10 * i + 2, 2)) for i in range(20)]
+    path = str(tmp_path / "trace.json")
+    with trace(path):
+        rdp_batch(lines, 0.1, num_threads=3)
+    with open(path) as f:
+        events = json.load(f)["traceEvents"]
+    tasks = [e for e in events if e["ph"] == "X"]
+    assert sorted(e["args"]["id"] for e in tasks) == list(range(20))
+    for e in tasks:
+        assert e["name"] == "iterative" and e["cat"] == "rdp_batch"
+        assert e["args"]["N"] == 10 * e["args"]["id"] + 2
+        assert e["dur"] >= 0 and e["tid"] > 0
+    # nothing recorded outside of the block
+    rdp_batch(lines, 0.1)
+    with trace(path):
+        pass
+    with open(path) as f:
+        assert [e["ph"] for e in json.load(f)["traceEvents"]] == ["M"]
+
+
+def test_rdp_batch_preserve_topology():
+    # simplified line1 would cross line2
+    line1 = [[0, 0], [5, -2], [10, 0]]
+    line2 = [[5, -1], [5, 0.5]]
+    ret = rdp_batch([line1, line2], 3.0)
+    assert ret[0].tolist() == [[0, 0], [10, 0]]
+    ret = rdp_batch([line1, line2], 3.0, preserve_topology=True)
+    assert ret[0].tolist() == line1
+    assert ret[1].tolist() == line2
+
+    # noisy contour lines (rings)
+    rng = np.random.default_rng(0)
+    theta = np.linspace(0, 2 * np.pi, 100)
+    lines = []
+    for k in range(8):
+        r = 3 + k * 0.6 + rng.uniform(-0.2, 0.2, 100)
+        r[-1] = r[0]
+        lines.append(np.c_[r * np.cos(theta), r * np.sin(theta)])
+
+    def num_crossings(lines):
+        return sum(
+            _num_crossings(lines[i], lines[j])
+            for i in range(len(lines))
+            for j in range(i + 1, len(lines))
+        )
+
+    assert num_crossings(lines) == 0
+    assert num_crossings(rdp_batch(lines, 1.0)) > 0
+    ret = rdp_batch(lines, 1.0, preserve_topology=True, num_threads=4)
+    assert num_crossings(ret) == 0
+    masks = rdp_batch(lines, 1.0, return_mask=True)
+    masks2 = rdp_batch(lines, 1.0, return_mask=True, preserve_topology=True)
+    for mask, mask2 in zip(masks, masks2):
+        assert np.all(mask2 >= mask)
+
+
+def test_simplify_geojson(tmp_path):
+    rng = np.random.default_rng(0)
+    theta = np.linspace(0, 2 * np.pi, 60)
+    ring = np.c_[5 * np.cos(theta), 5 * np.sin(theta)]
+    ring[-1] = ring[0]
+    features = []
+    for i in range(7):
+        coords = np.cumsum(rng.uniform(-1, 1, (50, 2 + i % 2)), axis=0)
+        features.append(
+            {
+                "type": "Feature",
+                "properties": {"id": i},
+                "geometry": {"type": "LineString", "coordinates": coords.tolist()},
+            }
+        )
+    polygon = {"type": "Polygon", "coordinates": [ring.tolist()]}
+    point = {"type": "Point", "coordinates": [1.5, 2.5]}
+    features.append({"type": "Feature", "properties": None, "geometry": polygon})
+    features.append({"type": "Feature", "properties": {}, "geometry": point})
+    features.append({"type": "Feature", "properties": {}, "geometry": None})
+    collection = {"type": "FeatureCollection", "name": "test", "features": features}
+    input_path = str(tmp_path / "input.json")
+    output_path = str(tmp_path / "output.json")
+    with open(input_path, "w") as f:
+        json.dump(collection, f)
+
+    # small window, features go through several batches
+    kwargs = dict(epsilon=0.5, window=3, num_threads=2)
+    num = simplify_geojson(input_path, output_path, **kwargs)
+    assert num == len(features)
+    with open(output_path) as f:
+        output = json.load(f)
+    assert output["name"] == "test"
+    assert len(output["features"]) == len(features)
+    for i in range(7):
+        feature = output["features"][i]
+        assert feature["properties"] == {"id": i}
+        coords = features[i]["geometry"]["coordinates"]
+        expected = rdp(coords, epsilon=0.5)
+        simplified = np.array(feature["geometry"]["coordinates"])
+        assert simplified.tolist() == expected.tolist()
+        assert len(expected) < len(coords)
+    rings = output["features"][7]["geometry"]["coordinates"]
+    assert len(rings) == 1 and 4 <= len(rings[0]) < len(ring)
+    assert rings[0][0] == rings[0][-1]
+    assert output["features"][8]["geometry"] == point
+    assert output["features"][9]["geometry"] is None
+
+    with open(input_path, "w") as f:
+        f.write('{"type": "FeatureCollection", "features": [1]}')
+    with pytest.raises(RuntimeError) as excinfo:
+        simplify_geojson(input_path, output_path)
+    assert "features should be objects" in str(excinfo.value)
+
+
+def test_flatgeobuf(tmp_path):
+    rng = np.random.default_rng(0)
+    lines = [np.cumsum(rng.uniform(-1, 1, (50, 3)), axis=0) for _ in range(30)]
+    lines.append(np.array([[100.0, 100.0, 1.0]]))  # single point
+    path = str(tmp_path / "lines.fgb")
+    write_flatgeobuf(path, lines)
+    with open(path, "rb") as f:
+        assert f.read(8) == b"fgb\x03fgb\x01"
+    # indexed: features in hilbert order
+    features = read_flatgeobuf(path)
+    assert len(features) == len(lines)
+    assert all(len(parts) == 1 for parts in features)
+    key = {tuple(line[0]) for line in lines}
+    assert {tuple(parts[0][0]) for parts in features} == key
+
+    for index in (True, False):
+        output_path = str(tmp_path / f"output{index}.fgb")
+        num = simplify_flatgeobuf(
+            path, output_path, epsilon=0.5, index=index, num_threads=2
+        )
+        assert num == len(lines)
+        expected = {tuple(line[0]): rdp(line, epsilon=0.5) for line in lines}
+        output = read_flatgeobuf(output_path)
+        assert len(output) == len(lines)
+        for (simplified,) in output:
+            assert np.array_equal(simplified, expected[tuple(simplified[0])])
+        if not index:
+            # input order
+            firsts = [tuple(parts[0][0]) for parts in output]
+            assert firsts == [tuple(parts[0][0]) for parts in features]
+
+    lines2d = [line[:, :2] for line in lines[:5]]
+    write_flatgeobuf(path, lines2d, index=False)
+    output = read_flatgeobuf(path)
+    assert all(np.array_equal(a, b) for (a,), b in zip(output, lines2d))
+
+    with open(path, "wb") as f:
+        f.write(b"not a flatgeobuf file")
+    with pytest.raises(RuntimeError):
+        read_flatgeobuf(path)
+
+    # offsets read from the file are checked (here the header's root offset)
+    write_flatgeobuf(path, lines)
+    with open(path, "rb") as f:
+        data = bytearray(f.read())
+    data[12:16] = (0x7FFF0000).to_bytes(4, "little")
+    with open(path, "wb") as f:
+        f.write(data)
+    with pytest.raises(RuntimeError, match="invalid FlatGeobuf"):
+        read_flatgeobuf(path)
+    with pytest.raises(RuntimeError, match="invalid FlatGeobuf"):
+        simplify_flatgeobuf(path, output_path, epsilon=0.5)
+
+
+def test_codec():
+    rng = np.random.default_rng(0)
+    lines = [np.cumsum(rng.uniform(-1, 1, (200, 3)), axis=0) for _ in range(10)]
+    masks = rdp_batch_mask(lines, epsilon=0.5)
+    for compress in (False, True) if has_zlib else (False,):
+        data = encode_polylines(lines, masks=masks, resolution=1e-3, compress=compress)
+        decoded = decode_polylines(data)
+        assert len(decoded) == len(lines)
+        for line, mask, coords in zip(lines, masks, decoded):
+            expected = line[mask.astype(bool)]
+            assert coords.shape == expected.shape
+            assert np.abs(coords - expected).max() <= 0.5e-3 + 1e-12
+    assert len(encode_polylines(lines, resolution=1e-3)) < sum(map(np.size, lines)) * 3
+
+    line = lines[0][:, :2]
+    mask = rdp_mask(line, epsilon=0.5)
+    (coords,) = decode_polylines(encode_polyline(line, mask=mask, resolution=0.5))
+    assert coords.shape == (mask.sum(), 2)
+    np.testing.assert_allclose(coords, np.round(line[mask.astype(bool)] * 2) / 2)
+    assert decode_polylines(encode_polylines([])) == []
+    # arrays read in place, others converted: same bytes
+    data = encode_polylines([line[::2], line], resolution=0.5)
+    same = [np.ascontiguousarray(line[::2]), np.asfortranarray(line)]
+    assert encode_polylines(same, resolution=0.5) == data
+    assert encode_polylines([x.tolist() for x in same], resolution=0.5) == data
+    with pytest.raises(ValueError, match="Nx3 or Nx2"):
+        encode_polylines([line, lines[0]])
+
+    with pytest.raises(ValueError):
+        decode_polylines(b"frdp\x01\x02")
+    # 1 line of 2^63 vertices: N * dims overflows
+    crafted = b"frdp\x01\x02" + struct.pack("<d", 1.0) + b"\x01"
+    crafted += b"\x80" * 9 + b"\x01" + b"\x00" * 5
+    assert len(crafted) == 30
+    with pytest.raises(ValueError, match="truncated"):
+        decode_polylines(crafted)
+    if not has_zlib:
+        with pytest.raises(RuntimeError, match="zlib"):
+            encode_polylines(lines, resolution=1e-3, compress=True)
+    with pytest.raises(ValueError):
+        encode_polyline(line, mask=mask[1:])
+
+
+def test_multires_index(tmp_path):
+    rng = np.random.default_rng(0)
+    lines = [np.cumsum(rng.uniform(-1, 1, (n, 3)), axis=0) for n in (500, 1, 2, 80)]
+    path = str(tmp_path / "lines.idx")
+    build_multires_index(path, lines, num_threads=2)
+    index = MultiResolutionIndex(path)
+    assert len(index) == len(lines) and index.dims == 3
+    for i, line in enumerate(lines):
+        coords = index.coords(i)
+        assert np.array_equal(coords, line) and not coords.flags.writeable
+        for eps in (0.0, 0.3, 1.0, 5.0):
+            mask = index.mask(i, epsilon=eps)
+            assert np.array_equal(mask, rdp_mask(line, epsilon=eps))
+            assert np.array_equal(index.simplify(i, epsilon=eps), line[mask == 1])
+    simplified = index.simplify(epsilon=1.0)
+    for coords, line in zip(simplified, lines):
+        assert np.array_equal(coords, rdp(line, epsilon=1.0))
+
+    lines2d = [line[:, :2] for line in lines]
+    build_multires_index(path, lines2d, min_epsilon=0.5, metric="vertical")
+    index = MultiResolutionIndex(path)
+    assert index.dims == 2 and index.min_epsilon == 0.5
+    assert np.array_equal(index.coords(0), lines2d[0])
+    for epsilon in (0.5, 2.0):
+        expected = rdp(lines2d[0], epsilon=epsilon, dist="vertical")
+        assert np.array_equal(index.simplify(0, epsilon=epsilon), expected)
+    with pytest.raises(ValueError):
+        index.simplify(0, epsilon=0.1)
+    with pytest.raises(IndexError):
+        index.coords(len(lines))
+    del index
+
+    # corrupted or truncated: checksum (and offsets) verified when opened
+    with open(path, "rb") as f:
+        data = bytearray(f.read())
+    data[len(data) // 2] ^= 0xFF
+    for corrupted in (data, data[: len(data) // 2]):
+        with open(path, "wb") as f:
+            f.write(corrupted)
+        with pytest.raises(RuntimeError, match="invalid multi-resolution index"):
+            MultiResolutionIndex(path)
+
+
+def test_geojsonvt():
+    rng = np.random.default_rng(0)
+    features = []
+    for i in range(100):
+        coords = np.cumsum(rng.uniform(-0.05, 0.05, (300, 2)), axis=0)
+        coords += rng.uniform(-20, 20, 2)
+        geometry = {"type": "LineString", "coordinates": coords.tolist()}
+        features.append({"type": "Feature", "properties": {}, "geometry": geometry})
+    geojson = json.dumps({"type": "FeatureCollection", "features": features})
+
+    def same(a, b):
+        if isinstance(a, list):
+            return len(a) == len(b) and all(map(same, a, b))
+        return np.array_equal(a, b)
+
+    def build(num_threads):
+        vt = GeoJSONVT(geojson, index_max_points=1000, num_threads=num_threads)
+        ids = vt.tile_ids()
+        tiles = [vt.tile(*i) for i in ids] + [vt.tile(9, 255, 250)]
+        return ids, tiles, vt.stats
+
+    ids, tiles, stats = build(num_threads=1)
+    assert len(ids) > 1 and stats[0] == 1
+    ids2, tiles2, stats2 = build(num_threads=4)
+    assert ids == ids2 and stats == stats2
+    for tile, tile2 in zip(tiles, tiles2):
+        assert tile["num_points"] == tile2["num_points"]
+        assert tile["num_simplified"] == tile2["num_simplified"]
+        assert len(tile["features"]) == len(tile2["features"])
+        for f, f2 in zip(tile["features"], tile2["features"]):
+            assert f["type"] == f2["type"]
+            assert same(f["coordinates"], f2["coordinates"])
+
+    # drilling down from several threads (gil released) gives the same tiles
+    vt = GeoJSONVT(geojson, index_max_points=1000, num_threads=2)
+    ids = [(z, x, y) for z, x, y in ids2 for _ in range(3)] + [(9, 255, 250)] * 3
+    with ThreadPoolExecutor(4) as pool:
+        drilled = list(pool.map(lambda i: vt.tile(*i), ids))
+    assert [t["num_points"] for t in drilled[::3]] == [t["num_points"] for t in tiles2]
+    assert vt.stats == stats2 and vt.total == sum(stats2.values())
+
+    # z/x/y are checked before narrowing (z 256 would be zoom 0), x wraps
+    for z, x, y in ((256, 0, 0), (-1, 0, 0), (0, 0, -1), (1, 0, 2), (19, 0, 0)):
+        with pytest.raises(RuntimeError):
+            vt.tile(z, x, y)
+    assert vt.tile(1, -1, 0)["num_points"] == vt.tile(1, 1, 0)["num_points"]
+
+    # z0: rdp (in web mercator, tolerance in tile units) is kept
+    coords = np.array(features[0]["geometry"]["coordinates"])
+    vt = GeoJSONVT(json.dumps(features[0]), tolerance=3, extent=4096)
+    (feature,) = vt.tile(0, 0, 0)["features"]
+    assert feature["type"] == "LineString"
+    sin = np.sin(np.radians(coords[:, 1]))
+    x = coords[:, 0] / 360 + 0.5
+    y = 0.5 - 0.25 * np.log((1 + sin) / (1 - sin)) / np.pi
+    expected = np.round(rdp(np.c_[x, y], epsilon=3 / 4096) * 4096)
+    assert 2 <= len(expected) <= len(feature["coordinates"]) < len(coords)
+    assert {tuple(p) for p in expected} <= {tuple(p) for p in feature["coordinates"]}
+
+
+def decode_mvt(tile):
+    """minimal MVT decoder: [(type, parts, tags)] of the only layer"""
+
+    def varint(data, i):
+        v = shift = 0
+        while True:
+            v |= (data[i] & 0x7F) << shift
+            shift += 7
+            i += 1
+            if data[i - 1] < 0x80:
+                return v, i
+
+    def fields(data):
+        # (field, value) of varint & length-delimited fields
+        i = 0
+        while i < len(data):
+            key, i = varint(data, i)
+            v, i = varint(data, i)
+            if key & 7 == 2:
+                v, i = data[i : i + v], i + v
+            yield key >> 3, v
+
+    def packed(data):
+        out, i = [], 0
+        while i < len(data):
+            v, i = varint(data, i)
+            out.append(v)
+        return out
+
+    def zigzag(v):
+        return (v >> 1) ^ -(v & 1)
+
+    (layer,) = [v for f, v in fields(tile) if f == 3]
+    features = []
+    for f, v in fields(layer):
+        if f != 2:
+            continue
+        feature = dict(fields(v))
+        commands = packed(feature[4])
+        parts, x, y, i = [], 0, 0, 0
+        while i < len(commands):
+            cmd, count = commands[i] & 7, commands[i] >> 3
+            i += 1
+            if cmd == 7:
+                parts[-1].append(parts[-1][0])
+                continue
+            for _ in range(count):
+                x += zigzag(commands[i])
+                y += zigzag(commands[i + 1])
+                i += 2
+                if cmd == 1:
+                    parts.append([])
+                parts[-1].append((x, y))
+        features.append((feature[3], parts, packed(feature.get(2, b""))))
+    return features
+
+
+def test_mvt():
+    rng = np.random.default_rng(0)
+    features = []
+    for i in range(20):
+        coords = np.cumsum(rng.uniform(-0.5, 0.5, (300, 2)), axis=0)
+        geometry = {"type": "LineString", "coordinates": coords.tolist()}
+        features.append({"type": "Feature", "properties": {}, "geometry": geometry})
+    # counterclockwise (in lon/lat) square with a hole
+    square = [[-5, -5], [5, -5], [5, 5], [-5, 5], [-5, -5]]
+    hole = [[-1, -1], [1, -1], [1, 1], [-1, 1], [-1, -1]]
+    polygon = {"type": "Polygon", "coordinates": [square, hole]}
+    properties = {"name": "a", "n": 1, "x": 0.5, "ok": True, "null": None}
+    features.append({"type": "Feature", "properties": properties, "geometry": polygon})
+    geojson = json.dumps({"type": "FeatureCollection", "features": features})
+    vt = GeoJSONVT(geojson, index_max_points=1000)
+
+    tile = vt.tile(0, 0, 0)
+    decoded = decode_mvt(vt.tile_mvt(0, 0, 0))
+    assert len(decoded) == len(tile["features"])
+    for (type, parts, tags), feature in zip(decoded, tile["features"]):
+        if feature["type"] == "LineString":
+            assert type == 2 and len(parts) == 1
+            coords = feature["coordinates"]
+            keep = np.r_[True, np.any(coords[1:] != coords[:-1], axis=1)]
+            assert parts[0] == [tuple(p) for p in coords[keep]]
+        else:
+            assert feature["type"] == "Polygon" and type == 3
+            assert len(parts) == 2 and len(tags) == 2 * 4
+
+            def area(ring):
+                x, y = np.array(ring, dtype=float).T
+                return np.sum(x[:-1] * y[1:] - x[1:] * y[:-1])
+
+            # exterior ring has positive area in tile coordinates
+            assert area(parts[0]) > 0 > area(parts[1])
+
+    ids = vt.tile_ids()
+    assert vt.tiles_mvt(ids) == [vt.tile_mvt(*i) for i in ids]
+
+    lines = [np.cumsum(rng.uniform(-10, 10, (50, 2)), axis=0) + 2000 for _ in range(3)]
+    tiles = encode_mvt([lines, lines[:1], []], num_threads=2)
+    assert len(tiles) == 3
+    for tile, expected in zip(tiles, [lines, lines[:1], []]):
+        decoded = decode_mvt(tile)
+        assert len(decoded) == len(expected)
+        for (type, (part,), tags), line in zip(decoded, expected):
+            assert type == 2 and not tags
+            assert part == [tuple(p) for p in np.round(line).astype(int)]
+
+
 def test_degenerate_case():
     # https://github.com/mapbox/geojson-vt/issues/104
     coords = []